@@ -11,7 +11,37 @@
 #include <chrono>
 #include <random>
 #include <algorithm>
-#include <regex>
+#include <charconv>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <deque>
+#include <memory>
+#include <array>
+#include <cstdint>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#include <csignal>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(RA_PROFILE) && defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
 
 #define _USE_MATH_DEFINES
 #ifdef _DEBUG
@@ -19,102 +49,451 @@
 #endif
 
 using namespace std;
-using Card = int [7];
-// Define constants related to Lotto 649.
-const int _drawRange = 49;		// The range of numbers that can be drawn (1-49).
-const int _drawCardSize = 7;		// The number of numbers drawn in each draw (6 + 1 bonus).
-const int _drawSampleSize = 500;		// A certain amount of draws that produce a somewhat stable(numbers don't move around wild) list. 
-const int _ordinalSampleSize = 500;		// same as above but for the ordinal lists.
-char _primeNumbers[15] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47};
+
+/* Game geometries.
+Each game is a set of compile-time constants: the ball range, how many main and bonus numbers are
+drawn from it, and the thresholds of the card validation rules (see Analyse::validate_card_mask).
+The whole program is specialized for one game per build, so every array is sized by constants and
+every combination loop is unrolled for that game. Lotto 6/49 is built by default; define
+RA_GAME_LOTTO_MAX to build for Lotto Max. Only single-pool games fit: every number, bonus included,
+is drawn from one range of at most 63 numbers, and a card has at least three main numbers. Games
+outside that (a 1-69 range, or a separate bonus pool such as Powerball's 5/69 + 1/26) are not
+supported, and the static_asserts below reject them.*/
+struct Lotto649 {
+    static constexpr int DrawRange = 49;     // Numbers 1-49.
+    static constexpr int MainNumbers = 6;    // Main numbers on a card.
+    static constexpr int BonusNumbers = 1;   // Bonus numbers drawn from the same pool.
+    static constexpr int EvenMin = 2, EvenMax = 4;   // Even main numbers.
+    static constexpr int LowBall = 24;               // Highest "low" number.
+    static constexpr int LowMin = 2, LowMax = 4;     // Low main numbers.
+    static constexpr int SumMin = 121, SumMax = 200; // Sum of the main numbers.
+    static constexpr int DecadeMax = 3;              // Main numbers in any one decade.
+};
+
+struct LottoMax {
+    static constexpr int DrawRange = 50;     // Numbers 1-50.
+    static constexpr int MainNumbers = 7;
+    static constexpr int BonusNumbers = 1;
+    static constexpr int EvenMin = 2, EvenMax = 5;
+    static constexpr int LowBall = 25;
+    static constexpr int LowMin = 2, LowMax = 5;
+    static constexpr int SumMin = 150, SumMax = 229;
+    static constexpr int DecadeMax = 3;
+};
+
+#if defined(RA_GAME_LOTTO_MAX)
+using Game = LottoMax;
+#else
+using Game = Lotto649;
+#endif
+
+// Define constants related to the game this build is specialized for.
+constexpr int _drawRange = Game::DrawRange;		// The range of numbers that can be drawn (1-49 for Lotto 649).
+constexpr int _drawMainNumbers = Game::MainNumbers;	// The main numbers of a draw; only these are validated on a card.
+constexpr int _drawCardSize = Game::MainNumbers + Game::BonusNumbers;	// The number of numbers drawn in each draw (6 + 1 bonus for Lotto 649).
+using Card = int [_drawCardSize];
+static_assert(_drawRange <= 63, "unsupported game: ball masks (CardMask) hold at most 63 numbers");
+static_assert(_drawMainNumbers >= 3 && _drawCardSize <= _drawRange, "unsupported game: the combination engines need at least three main numbers");
 using DrawMatrix = std::vector<std::vector<int>>;
 using DrawSet = std::vector<int>;
 
-// Define a struct to hold statistics for each number.
-struct DrawStatisticNode{
-
-	int totalTimesDrawn;		// How many times this number has been drawn.
-	int drawNumber;				// The number itself.
-	bool isDrawn;				// Flag indicating if the number was drawn.
-	double ordinalChance;		// The summation of all the ordinal averages that point to the postion this number is in on the draw list.
-	int drawOpportunities; 			// Each attempt to draw this number from the avaliable balls. 
-	double average;				// the average as times drawn over total opportunities.
-	int lastDrawn;				// The amount of draws that have past since it was last drawn.
-	DrawStatisticNode *_next;
+struct DrawRecord {
+/* One validated draw from the draw history, as held in the in-memory draw array.
+The whole history is decoded into a flat vector of these, so the analyzer walks plain memory
+instead of re-reading and re-parsing text.*/
+
+    uint32_t date;                  // Draw date packed as YYYYMMDD.
+    uint8_t balls[_drawCardSize];   // The drawn numbers in draw order (main numbers, then bonus).
+};
+
+// Cards can also be held as 64-bit ball masks: bit b is set when ball b is on the card.
+// The validation rules then become mask ANDs and popcounts.
+using CardMask = uint64_t;
+
+// Mask of every ball from low to high (inclusive).
+constexpr CardMask ball_range_mask(int low, int high) {
+	return (~0ULL >> (63 - high)) & ~((1ULL << low) - 1);
+}
+
+// Mask of every even ball in the draw range.
+constexpr CardMask even_ball_mask() {
+	CardMask mask = 0;
+	for (int ball = 2; ball <= _drawRange; ball += 2)
+		mask |= 1ULL << ball;
+	return mask;
+}
+
+// Mask of every prime ball in the draw range.
+constexpr CardMask prime_ball_mask() {
+	CardMask mask = 0;
+	for (int ball = 2; ball <= _drawRange; ball++) {
+		bool prime = true;
+		for (int divisor = 2; divisor * divisor <= ball; divisor++)
+			prime = prime && ball % divisor != 0;
+		if (prime)
+			mask |= 1ULL << ball;
+	}
+	return mask;
+}
+
+// Number of decades in the draw range: 1-9, 10-19, 20-29, ...
+constexpr int _drawDecades = _drawRange / 10 + 1;
+
+// Mask of the balls of every decade.
+constexpr std::array<CardMask, _drawDecades> decade_ball_masks() {
+	std::array<CardMask, _drawDecades> masks = {};
+	for (int decade = 0; decade < _drawDecades; decade++)
+		masks[decade] = ball_range_mask(std::max(1, decade * 10), std::min(_drawRange, decade * 10 + 9));
+	return masks;
+}
+
+constexpr CardMask PrimeBallMask = prime_ball_mask();
+constexpr CardMask EvenBallMask = even_ball_mask();
+constexpr CardMask LowBallMask = ball_range_mask(1, Game::LowBall);
+constexpr std::array<CardMask, _drawDecades> DecadeBallMask = decade_ball_masks();
+
+inline int popcount64(CardMask mask) {
+#ifdef _MSC_VER
+	return static_cast<int>(__popcnt64(mask));
+#else
+	return __builtin_popcountll(mask);
+#endif
+}
+
+// Index of the lowest set bit of a non-zero mask.
+inline int lowest_bit64(uint64_t mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(mask);
+#endif
+}
+
+// Number of ways to choose k numbers out of n (0 when k is out of range).
+constexpr long long binomial(int n, int k) {
+	if (k < 0 || k > n) return 0;
+	long long result = 1;
+	for (int i = 1; i <= k; i++)
+		result = result * (n - k + i) / i;
+	return result;
+}
+static_assert(binomial(_drawRange, _drawCardSize) <= 0xffffffffLL, "colex ranks are stored as 32-bit values");
+
+/* Compile-time combination enumerators.
+Each one expands into 'Depth' nested loops when it is instantiated, so a card of any size is walked
+by straight loops with no recursion or size checks left at run time. 'step(state, number, position)'
+returns the running state (mask, sum, score, ...) extended by one number, where 'position' is the
+number of numbers still to choose including this one; 'visit(state)' is called for every complete set.*/
+
+// Visits every set of 'Depth' numbers below 'limit' in colex order (the highest number changes slowest).
+// Here 'position' is also the 1-based slot of the number within the set.
+template <int Depth, class State, class Step, class Visit>
+inline void for_each_colex_set(int limit, const State& state, Step& step, Visit& visit) {
+	if constexpr (Depth == 0)
+		visit(state);
+	else
+		for (int number = Depth; number < limit; number++)
+			for_each_colex_set<Depth - 1>(number, step(state, number, Depth), step, visit);
+}
+
+// Visits every set of 'Depth' numbers from 'low' to 'high' in lexicographic order (the lowest number changes slowest).
+template <int Depth, class State, class Step, class Visit>
+inline void for_each_lex_set(int low, int high, const State& state, Step& step, Visit& visit) {
+	if constexpr (Depth == 0)
+		visit(state);
+	else
+		for (int number = low; number <= high - Depth + 1; number++)
+			for_each_lex_set<Depth - 1>(number + 1, high, step(state, number, Depth), step, visit);
+}
+
+struct CardPrefix {
+/* The numbers chosen so far while a card is enumerated in ascending order, with the ball mask
+and sum of the main numbers among them (the validation inputs).*/
+
+    int balls[_drawCardSize];  // Chosen numbers in ascending order.
+    int size;                  // How many numbers have been chosen.
+    CardMask mask;             // Mask of the chosen main numbers.
+    int sum;                   // Sum of the chosen main numbers.
+
+    // The prefix extended by the next (larger) number.
+    CardPrefix with(int number) const {
+        CardPrefix next = *this;
+        next.balls[next.size++] = number;
+        if (size < _drawMainNumbers) {
+            next.mask |= 1ULL << number;
+            next.sum += number;
+        }
+        return next;
+    }
+};
+
+// Define a struct to hold statistics for every number.
+struct DrawStatisticTable {
+/* Struct-of-arrays holding the statistics for every draw number.
+Each column is indexed by ball (ball number - 1), so looking up a number is a single array access
+instead of a walk down a linked list, and the whole table fits in a handful of cache lines.
+The order of the draw list (sorted by average) is kept separately in 'rankedBall', so sorting
+only moves ball indices around instead of swapping every statistic field.*/
+
+	int totalTimesDrawn[_drawRange];	// How many times this number has been drawn.
+	bool isDrawn[_drawRange];			// Flag indicating if the number was drawn.
+	double ordinalChance[_drawRange];	// The summation of all the ordinal averages that point to the postion this number is in on the draw list.
+	double ordinalSigma[_drawRange];	// Standard error of ordinalChance: the root of the summed variances of those averages.
+	int drawOpportunities[_drawRange]; 	// Each attempt to draw this number from the avaliable balls. 
+	double average[_drawRange];			// the average as times drawn over total opportunities.
+	int lastDrawn[_drawRange];			// The draw number (1-based position in the history) in which this number was last drawn.
+	int rankedBall[_drawRange];			// Rank -> ball permutation: rankedBall[0] is the ball at the top of the draw list.
+	int ballRank[_drawRange];			// Ball -> rank inverse index, kept in step with rankedBall.
+};
+
+// Row length of the pair matrix: the counts of a row fill whole 64-byte cache lines.
+constexpr int _pairStride = (_drawRange + 15) / 16 * 16;
+
+// Number of triples of draw numbers (C(49, 3) = 18,424 for Lotto 649).
+constexpr int _tripleCount = _drawRange * (_drawRange - 1) * (_drawRange - 2) / 6;
+
+// Colex rank of the triple a < b < c (balls 0-based): its slot in CoOccurrenceTable::tripleDrawn.
+constexpr int triple_index(int a, int b, int c) {
+	return c * (c - 1) * (c - 2) / 6 + b * (b - 1) / 2 + a;
+}
+
+struct CoOccurrenceTable {
+/* Draw counts of every pair and every triple of draw numbers.
+The pairs are a square matrix, indexed by ball on both sides, with each row padded to whole cache lines:
+pairDrawn[a][b] is the number of draws that held both a and b, and the diagonal pairDrawn[a][a] the draws
+that held a. A draw adds its indicator row (1 in the column of every number drawn) to the row of each
+number drawn, so the update is a vector add over one row per number. The triples are stored once each,
+in colex order (triple_index), and a draw increments the 35 it holds.
+Every draw recorded could have held every pair and triple, so 'draws' is the opportunity count of each
+group and a group's average is its count over 'draws'.*/
+
+	alignas(64) uint32_t pairDrawn[_drawRange][_pairStride];
+	uint32_t tripleDrawn[_tripleCount];
+	uint32_t draws;                     // Draws recorded: the opportunities of every pair and triple.
+};
+
+struct GroupStatistic {
+// One pair or triple of draw numbers, as reported by the co-occurrence queries.
+	int size;                           // 2 for a pair, 3 for a triple.
+	int balls[3];                       // The numbers (1-based) in ascending order; the first 'size' are used.
+	uint32_t drawn;                     // Draws that held every number of the group.
+	double average;                     // drawn over the draws recorded.
+};
+
+struct CardGroupScore {
+// Contribution of a card's pairs and triples to its score: the sums of their averages.
+	double pairs;
+	double triples;
 };
 
-struct OrdinalStatisticNode {
-/* Struct to represent the data for a specific ordinal position in a draw probability list.
-This list contains 49 elements, each element referencing a rank (ordinal) in another list
-of 49 elements that are sorted by probability. The referenced list could be a list of draw
-numbers or another list of ordinal positions (ordinal list).*/
-    
-    int landedTotal;     // The total number of times a number has landed in this specific ordinal position.
-    int ordinal;         // The rank or position in the referenced list (another 49-element list).
-                         // This ordinal points to a specific rank in a list sorted by probability.
-    int opportunities;   // The number of times this ordinal position had the chance to hold a drawn number.
-                         // It counts the draw events where this position could have been selected.
-    double ordinalChance;// The cumulative probability that this ordinal position will hold a drawn number.
-                         // This is calculated by summing the average probabilities (ordinal averages) of
-                         // all ordinal list elements that reference this element, plus this element's own average.
-    double average;      // The probability that the drawn number was referenced by this ordinal.
-                         // In other words, this is the probability that this ordinal position holds the drawn number.
-    bool isDrawn;        // Flag indicating whether the number was actually drawn in this position during the current draw sequence.
-    
-    // Pointer to the next node in the linked list, representing the next ordinal position.
-    OrdinalStatisticNode *_next;
-/* end of struct
+struct OrdinalBranchNode{
+/* Struct to represent one level (branch) of the ordinal tree: a draw probability list of 49 ordinal positions.
+Each element references a rank (ordinal) in another list of 49 elements that are sorted by probability.
+The referenced list is the draw number list for the first level, and the level before it for every other level.
+The statistics are stored as fixed 49-slot columns indexed by ordinal (0-based), so a level is one flat block
+of memory, and all levels live next to each other in the ordinal tree arena (Analyse::_ordinalTree).
+When the number of events (sampleSize) reaches a certain threshold (_ordinalSampleSize) on the last level,
+a new level is appended to the arena.*/
+
+    int landedTotal[_drawRange];       // The total number of times a number has landed in this specific ordinal position.
+    int opportunities[_drawRange];     // The number of times this ordinal position had the chance to hold a drawn number.
+                                       // It counts the draw events where this position could have been selected.
+    double ordinalChance[_drawRange];  // The cumulative probability that this ordinal position will hold a drawn number.
+                                       // This is calculated by summing the average probabilities (ordinal averages) of
+                                       // all ordinal list elements that reference this element, plus this element's own average.
+    double average[_drawRange];        // The probability that the drawn number was referenced by this ordinal.
+                                       // In other words, this is the probability that this ordinal position holds the drawn number.
+    int rankedOrdinal[_drawRange];     // Rank -> ordinal (0-based) permutation: the list sorted by average.
+    int ordinalRank[_drawRange];       // Ordinal -> rank inverse index (the per-level position index), kept in step with rankedOrdinal.
+    int sampleSize;                    // Number of times this List recorded an event (draw events or opportunities).
+/*	end of struct
 
 Detailed Explanation:
-- This struct is part of a list of 49 elements. Each element represents an ordinal position
-  in the draw probability list.
-- The 'ordinal' field references a specific rank in another 49-element list, which is sorted
-  by probability. This referenced list could either be the list of draw numbers or another ordinal list.
+- Slot 'o' of every column holds the statistics of ordinal o + 1, which references rank o + 1 in the
+  list one level down (the draw list for level 0). The slots never move.
+- The sorted order of the list is held by the 'rankedOrdinal' / 'ordinalRank' pair, so finding the position
+  of an ordinal, or the ordinal at a position, is a single array access.
 - The 'ordinalChance' field represents the cumulative probability that this ordinal position will hold a drawn number.
   It is calculated by summing the average probabilities (ordinal averages) of all ordinal list elements
-  that reference this element, plus this element's own average. This means that each ordinal list is interconnected
-  with others through the 'ordinalBranch' structure, where each element is referenced by an element in the _next listNode.
+  that reference this element, plus this element's own average. Each level is referenced by the level after it.
 - The 'average' field indicates the probability that the drawn number is referenced by this ordinal.
   Essentially, it's the probability that this specific position in the list will contain the drawn number.
 - The 'opportunities' field counts how many times this ordinal position had the opportunity to hold a drawn number.
-  This provides a more detailed view of the draw events, treating each draw as a separate set of 7 random events instead of 1. */
+  This provides a more detailed view of the draw events, treating each draw as a separate set of 7 random events instead of 1.
+- 'sampleSize' keeps track of the number of events recorded in the current list.
+  When this sample size reaches a predetermined threshold (_ordinalSampleSize) on the last level, the system instantiates
+  a new ordinal list, effectively creating a new level to continue tracking events without losing historical data.
+- Level 0 is the first list, which references the draw number list directly. The last level in the arena is where
+  the summation process for calculating the cumulative probability (ordinalChance) starts: from this last list, the
+  cumulative probability is computed by summing the relevant averages and propagating this information back through
+  the levels, one pass over the whole level at a time (see Analyse::correlate_data). */
 };
 
-struct OrdinalBranchNode{
-/* Struct to manage the interconnection between ordinal lists.
-Each ordinal list can reference elements in other lists through the _next listNode,
-and these references are managed by the 'ordinalBranch' structure. This structure
-is part of a double-linked list and tracks the number of recorded events. When the number of
-events (sampleSize) reaches a certain threshold (_ordinalSampleSize), a new ordinal list can be instantiated.*/
+struct OrdinalDrawBatch {
+/* Struct to collect every ordinal update produced by a single draw.
+While a draw is processed the draw list does not move, so the draw events and opportunities
+it produces can be gathered first and then applied to the ordinal tree level by level:
+each level takes the whole draw in one pass instead of one walk down the tree per update.*/
 
+    int position[_drawRange * _drawCardSize];  // Draw list rank (0-based) of each update, in the order the draw produced them.
+    int landed[_drawRange * _drawCardSize];    // 1 if the update is a draw event, 0 if it is an opportunity.
+    int size;                                  // Number of updates collected for the current draw.
+    int events;                                // Number of those updates that are draw events.
+};
 
-    OrdinalStatisticNode *listNode;  // Pointer to the head node of the ordinal list.
-    int sampleSize;             // Number of times this List recorded an event (draw events or opportunities).
-    OrdinalBranchNode *_next;       // Pointer to the next branch in the double-linked list.
-    OrdinalBranchNode *_previous;   // Pointer to the previous branch in the double-linked list.
-/*	end of struct
+struct OrdinalLevelStream {
+/* The progress of one draw down the ordinal tree (see Analyse::advance_ordinal_stream).
+The draw enters the first live level as two histograms over its slots and leaves every level as the
+histograms over the slots of the next one, so a draw can be carried part of the way down and picked up
+again later. Pipelined ingest hands streams from one group of levels to the next; it also keeps the draw
+list rank -> slot mapping composed through the levels passed, to seed a level created further down
+without going back to levels that may have been re-sorted since.*/
+
+    int depth;                      // Next level (arena index) to apply the draw to.
+    int levels;                     // Levels in the tree as far as this draw has seen.
+    int landed[_drawRange];         // Draw events per slot entering level 'depth'.
+    int opportunities[_drawRange];  // Updates (events and opportunities) per slot entering level 'depth'.
+    int events;                     // Draw events entering level 'depth'.
+    int streamStart;                // First update of the batch that reaches level 'depth'.
+    bool finished;                  // The draw has been applied to the last level.
+    bool trackSlots;                // Keep 'slot' up to date.
+    int slot[_drawRange];           // Draw list rank -> slot of level 'depth' (only with trackSlots).
+};
 
-Detailed Explanation:
-- The 'ordinalBranch' struct manages the connections between different ordinal lists and tracks the 
-  number of recorded events within each list.
-- 'listNode' points to the head of the current ordinal list, which is a list of 49 ordinalListNode elements.
-- 'sampleSize' keeps track of the number of events (e.g., draws or opportunities) recorded in the current list.
-  When this sample size reaches a predetermined threshold (_ordinalSampleSize), the system can instantiate a new ordinal list,
-  effectively creating a new branch in the structure to continue tracking events without losing historical data.
-- '_next' and '_previous' create a double-linked list structure, allowing traversal both forward and backward 
-  through the chain of ordinal branches. This double-linking facilitates efficient navigation and management of 
-  multiple interconnected lists, supporting complex probability analysis.
-- When '_previous' is null, it indicates that we are at the first list, which references the draw number list directly.
-- When '_next' is null, it indicates that we are at the last list in the chain, where the ordinals reference the _previous listNode.
-  This position is significant because it marks the start of the summation process for calculating the cumulative probability
-  (ordinalChance) across all interconnected lists. From this last list, the cumulative probability is computed by summing
-  the relevant averages and propagating this information back through the chain of ordinal branches. */
+struct OrdinalGrowthPolicy {
+/* Limits on the growth of the ordinal tree. Without them a level is added every few dozen draws and
+every draw walks every level, so both memory and the cost of a draw grow with the history.*/
+
+    int maxLevels = 0;            // Deepest the tree may grow, retired levels included; 0 is unlimited.
+    size_t memoryBudget = 0;      // Bytes the live levels may occupy; 0 is unlimited.
+    int retireSampleSize = 0;     // The oldest live level is retired once its sample size reaches this; 0 never retires.
+};
+
+// Statistics correlate_data sums along the ordinal chains, all in the same pass.
+// Each level contributes one value per ordinal for each metric (see ordinal_level_metrics).
+enum OrdinalMetric {
+    MetricAverage,     // The ordinal's average; the sums are the ordinalChance.
+    MetricVariance,    // The variance of that average, average * (1 - average) / opportunities; the sums give ordinalSigma.
+    OrdinalMetricCount
+};
+
+struct RetiredOrdinalLevels {
+/* Summary of the retired (frozen) oldest levels of the ordinal tree.
+A retired level no longer changes: its averages and its sorted order stay as they were when it was
+retired, so a chain of retired levels reduces to two fixed mappings and one fixed sum per position.
+Updates cross all of them with one lookup (liveSlot) and correlate_data adds their metrics in one step,
+while their blocks are released from the arena.*/
+
+    int levels;                     // Number of retired levels; the first live level is level 'levels' + 1.
+    int liveSlot[_drawRange];       // Draw list rank -> slot of the first live level the update lands on.
+    int drawRank[_drawRange];       // Rank in the last retired level -> draw list rank, following the ordinals down.
+    double metricSum[OrdinalMetricCount][_drawRange];  // Sum of each retired metric met on that walk down.
+};
+
+// Statistic the draw list and the ordinal lists are ranked (sorted) by.
+enum class RankingStatistic {
+    Lifetime,   // The lifetime averages (the 'average' columns).
+    Window,     // The averages over the last RecencyPolicy::window draws.
+    Decayed     // The exponentially decayed averages.
+};
+
+struct RecencyPolicy {
+/* Which recency-weighted statistics are kept next to the lifetime ones, and which average ranks the lists.
+A lifetime average weighs a draw from decades ago the same as the latest one. The windowed statistics only
+count the last 'window' draws, and the decayed ones weigh every draw by another factor of 'decay' per newer draw.*/
+
+    int window = 0;                                          // Draws in the sliding window; 0 keeps no windowed statistics.
+    double decay = 0.0;                                      // Weight a draw keeps per newer draw (0 < decay < 1); 0 keeps no decayed statistics.
+    RankingStatistic ranking = RankingStatistic::Lifetime;   // The average the draw list and the ordinal lists are sorted by.
+
+    bool enabled() const { return window > 0 || decay > 0.0; }
+
+    // Whether the statistics a ranking needs are kept; the lists fall back to the lifetime averages otherwise.
+    bool keeps(RankingStatistic statistic) const {
+        return statistic == RankingStatistic::Lifetime
+            || (statistic == RankingStatistic::Window && window > 0)
+            || (statistic == RankingStatistic::Decayed && decay > 0.0);
+    }
+};
+
+struct RecencyColumns {
+/* Windowed and decayed counterparts of the statistics of one list (the draw table or one ordinal level).
+Each column is indexed by slot, like the list's own columns: by ball for the draw table, by ordinal for a level.*/
+
+    int windowLanded[_drawRange];            // Events in the last 'window' draws.
+    int windowOpportunities[_drawRange];     // Opportunities in the last 'window' draws.
+    double windowAverage[_drawRange];        // windowLanded / windowOpportunities; 0 without opportunities.
+    double decayedLanded[_drawRange];        // Events, each weighted by decay ^ (draws since it happened).
+    double decayedOpportunities[_drawRange]; // Opportunities, weighted the same way.
+    double decayedAverage[_drawRange];       // decayedLanded / decayedOpportunities; 0 without opportunities.
+    uint8_t pendingLanded[_drawRange];       // The current draw's deltas; a slot takes at most one event and
+    uint8_t pendingOpportunities[_drawRange];// _drawCardSize opportunities per draw.
+    int next;                                // Ring entry the next closed draw is written to.
+    int filled;                              // Draws held in the ring, up to 'window'.
+};
+
+struct RecencyStatistics {
+/* The recency-weighted statistics of one list, maintained incrementally.
+An update only adds to the current draw's deltas. When the draw closes, its deltas are written to a ring
+holding the deltas of the last 'window' draws, and the deltas of the draw leaving the window are taken back
+out of the windowed sums, so nothing is ever recounted. The decayed sums are scaled once and take the deltas.
+The cost is O(1) per update plus one pass over the 49 slots per draw.*/
+
+    RecencyColumns columns;
+    std::vector<uint8_t> ring;  // 'window' entries of 2 x _drawRange deltas: the landed deltas, then the opportunity deltas.
+    int window = 0;
+    double decay = 0.0;
+
+    // Clears the statistics and sizes the ring for the policy.
+    void reset(const RecencyPolicy& policy);
+
+    // Adds one update (an event when 'landed' is 1, an opportunity otherwise) to the current draw.
+    void record(int slot, int landed) {
+        columns.pendingLanded[slot] += static_cast<uint8_t>(landed);
+        columns.pendingOpportunities[slot]++;
+    }
+
+    // Adds a whole draw's updates, given as per-slot histograms, to the current draw.
+    void record_histogram(const int *landed, const int *opportunities);
+
+    // Closes the current draw: moves its deltas into the window and the decayed sums.
+    void close_draw();
+
+    // The averages of a recency ranking (Window or Decayed), indexed by slot.
+    const double *ranking_average(RankingStatistic ranking) const {
+        return ranking == RankingStatistic::Window ? columns.windowAverage : columns.decayedAverage;
+    }
+
+    // Bytes of one list's recency state in a snapshot: the columns followed by the ring.
+    static size_t state_bytes(const RecencyPolicy& policy) {
+        return sizeof(RecencyColumns) + static_cast<size_t>(policy.window) * 2 * _drawRange;
+    }
 };
 
-/*	TODO: Future updates to the `ordinalListNode` and `ordinalBranch` structs:
+/*	TODO: Future updates to the `OrdinalBranchNode` struct:
 - Consider introducing a child struct to encapsulate all calculated statistics (average, sigma, standard deviation, etc.).
 - This child struct will help organize the data and make it easier to extend the functionality of statistical propagation.
-- Each statistical metric (e.g., average, sigma, sd) should be updated consistently across the linked list of ordinal branches.
-- The `propagate_statistical_tree` function will need to be expanded to handle these additional metrics.*/
+- Each statistical metric (e.g., average, sigma, sd) should be updated consistently across the levels of the ordinal tree.
+- `correlate_data` already propagates every OrdinalMetric at once; a new metric only needs an entry in the enum
+  and its per-ordinal value in `ordinal_level_metrics`.*/
+
+// Per-ball statistic a card is scored by.
+enum class CardScoreMetric { OrdinalChance, Average };
+
+// How the weights of a card's numbers are combined into its score.
+enum class CardScoreCombine { Sum, Product };
+
+// Severity of a log record (see Logger).
+enum class LogLevel { Trace, Debug, Info, Warning, Error };
+
+// Default path of the combination index. The game geometry is part of the name ("6+1of49" for Lotto 649),
+// so builds for different games do not overwrite each other's index.
+inline string default_combination_index_file() {
+    return "./combinationIndex-" + std::to_string(_drawMainNumbers) + "+" + std::to_string(Game::BonusNumbers)
+         + "of" + std::to_string(_drawRange) + ".bin";
+}
 
 struct Config {
 /* Struct to manage the configuration settings for the analysis program.
@@ -124,1119 +503,4103 @@ This struct holds file paths for important data files and a flag for enabling or
                                        // This file contains precomputed or collected combinations used in the analysis.
     string drawHistoryFile;            // Path to the file that stores the history of draws.
                                        // This CSV file contains the historical draw data in a specific order (e.g., new_draw_order.csv).
+    string combinationIndexFile;       // Path to the binary combination index (validity bitset keyed by colex rank).
+                                       // It is created from the validation rules when it is missing or out of date.
+    bool combinationRankList;          // Flag to also store the packed list of valid ranks in the combination index.
+    bool watchHistory;                 // Flag to stay resident after the analysis and follow drawHistoryFile for appended draws.
+    string snapshotFile;               // Path to the analyzer snapshot (the full Analyse state after the last run).
+                                       // When set, a run resumes from it and only processes the draws appended since. Empty disables it.
+    string exportPrefix;               // Path prefix of the statistics export files (<prefix>.draws.csv, <prefix>.columns, ...).
+    unsigned exportFormats;            // Export formats, a comma separated list of "csv", "jsonl" and "binary"; empty disables the exports.
     bool debugMode;                    // Flag to enable or disable debug mode.
                                        // When set to true, additional debug information will be logged or displayed.
+    LogLevel logLevel;                 // Lowest level of the log records that are written ("trace", "debug", "info", "warning" or "error").
+                                       // debugMode lowers it to at least "debug"; per-ball tracing needs "trace".
+    int workerThreads;                 // Number of worker threads for the parallel engines.
+                                       // 0 means one thread per available core.
+    int scoreTopCards;                 // Number of best and worst cards to report after scoring every valid combination.
+                                       // 0 skips the scoring run.
+    int coOccurrenceTop;               // Number of most frequent pairs and triples to report; 0 skips the report.
+    CardScoreMetric scoreMetric;       // Per-ball statistic the cards are scored by ("ordinalChance" or "average").
+    CardScoreCombine scoreCombine;     // How the per-ball weights are combined ("sum" or "product").
+    int drawSampleSize;                // Draws processed before the ordinal tree starts (seeding phase).
+    int ordinalSampleSize;             // Events on the last ordinal level before a new level is added.
+    int ordinalMaxLevels;              // Deepest the ordinal tree may grow; 0 is unlimited.
+    long long ordinalMemoryBudget;     // Bytes the live ordinal levels may occupy; 0 is unlimited.
+    int ordinalRetireSampleSize;       // Sample size at which the oldest ordinal level is frozen and retired; 0 never retires.
+    bool correlateEveryDraw;           // Flag to correlate the ordinal tree after every draw instead of once after the history.
+    int pipelineThreads;               // Threads that replay the history with the ordinal levels split between them; 0 or 1 replays on one thread.
+                                       // Not used with ordinalRetireSampleSize or correlateEveryDraw.
+    int statisticWindow;               // Draws in the sliding window of the windowed statistics; 0 keeps none.
+    double statisticDecay;             // Per-draw weight of the exponentially decayed statistics (between 0 and 1); 0 keeps none.
+    RankingStatistic rankingStatistic; // Average the lists are sorted by ("lifetime", "window" or "decayed").
+    bool loadTest;                     // Flag to hold back the last testDrawCount draws of the history for testing.
+    int testDrawCount;                 // Number of draws held back for testing.
+    std::vector<int> sweepDrawSampleSizes;    // drawSampleSize values of the parameter sweep grid.
+    std::vector<int> sweepOrdinalSampleSizes; // ordinalSampleSize values of the parameter sweep grid.
+    std::vector<int> sweepTestDrawCounts;     // testDrawCount values of the parameter sweep grid.
+                                              // The sweep runs when any list is set; unset lists use the single value above.
+    long long simulations;             // Number of uniform synthetic histories for the null distributions; 0 skips them.
+    uint64_t simulationSeed;           // Seed of the synthetic histories.
+    int backtestSplits;                // Number of walk-forward split points to backtest; 0 skips the backtest.
+    int backtestHorizon;               // Draws scored after each split point.
+    int backtestTopN;                  // Size of the top-N list the backtest counts hits in.
 
     /* Constructor to initialize the configuration with default values.
     - combinationCollectionFile is initialized to "./combinationCollectionFile.dat"
     - drawHistoryFile is initialized to "./new_draw_order.csv"
-    - debugMode is initialized to false (debug mode off by default)*/
+    - debugMode is initialized to false (debug mode off by default) and logLevel to info
+    - combinationIndexFile is initialized to "./combinationIndex-6+1of49.bin" for Lotto 649 (see default_combination_index_file),
+      without the packed rank list
+    - snapshotFile is initialized to "" (snapshots off)
+    - exportPrefix is initialized to "./statistics", with no export formats (exports off)
+    - watchHistory is initialized to false (run once and exit)
+    - workerThreads is initialized to 0 (use every core)
+    - no cards are scored (scoreTopCards 0); when enabled they are scored by the sum of their ordinalChance
+    - the most frequent pairs and triples are not reported (coOccurrenceTop 0)
+    - the backtest is off; when enabled it scores 1 draw per split against the top 6
+    - no null-distribution simulations (seed 1 when enabled)
+    - both sample sizes are 500 and 100 draws are held back when test mode is on (off by default); no sweep
+    - the ordinal tree grows without limit and never retires a level, and is correlated once after the history
+    - the history is replayed on one thread (no pipelined ingest)
+    - no windowed or decayed statistics; the lists are ranked by their lifetime averages*/
     Config() : combinationCollectionFile("./combinationCollectionFile.dat"),
                drawHistoryFile("./new_draw_order.csv"),
-               debugMode(false) {}
+               combinationIndexFile(default_combination_index_file()),
+               combinationRankList(false),
+               watchHistory(false),
+               snapshotFile(""),
+               exportPrefix("./statistics"),
+               exportFormats(0),
+               debugMode(false),
+               logLevel(LogLevel::Info),
+               workerThreads(0),
+               scoreTopCards(0),
+               coOccurrenceTop(0),
+               scoreMetric(CardScoreMetric::OrdinalChance),
+               scoreCombine(CardScoreCombine::Sum),
+               drawSampleSize(500),
+               ordinalSampleSize(500),
+               ordinalMaxLevels(0),
+               ordinalMemoryBudget(0),
+               ordinalRetireSampleSize(0),
+               correlateEveryDraw(false),
+               pipelineThreads(0),
+               statisticWindow(0),
+               statisticDecay(0.0),
+               rankingStatistic(RankingStatistic::Lifetime),
+               loadTest(false),
+               testDrawCount(100),
+               simulations(0),
+               simulationSeed(1),
+               backtestSplits(0),
+               backtestHorizon(1),
+               backtestTopN(6) {}
 };
 
-class Analyse
-{
-public:
-    // Displays statistics for all drawn numbers, including total times drawn, opportunities, and averages.
-    void display_draw_statistics();
+/* Instrumentation.
+Built with -DRA_PROFILE the analyzer keeps phase timers and counters, and prints a profile report on exit
+when it is started with --profile. Without RA_PROFILE every PROFILE_ macro below expands to nothing, so
+the hot paths carry no instrumentation at all.
+Each thread counts into its own block, which is folded into the process totals when the thread exits,
+so the parallel engines never contend on a counter. Phase times are inclusive: a draw update contains
+the batch update and the sorts it triggers.*/
+enum class ProfilePhase { Ingest, DrawUpdate, OrdinalBatch, DrawSort, OrdinalSort, Correlation, CoOccurrence, Combinations, Scoring, Count };
+enum class ProfileCounter { ListWalkSteps, SortSwaps, OrdinalLevelsCreated, OrdinalLevelsRetired, DrawEvents, DrawOpportunities, OrdinalEvents, OrdinalOpportunities, Count };
+enum class ProfileMemory { DrawHistory, OrdinalTree, Combinations, Count };
+
+#if defined(RA_PROFILE)
+struct ProfileCounts {
+    uint64_t phaseNanos[static_cast<int>(ProfilePhase::Count)] = {};
+    uint64_t phaseCalls[static_cast<int>(ProfilePhase::Count)] = {};
+    uint64_t counters[static_cast<int>(ProfileCounter::Count)] = {};
+    uint64_t allocatedBytes[static_cast<int>(ProfileMemory::Count)] = {};
+};
 
-    // Displays the ordinal lists across all ordinal branches, showing each ordinal's position, average, and other statistics.
-    void display_ordinal_lists();
+// Adds this thread's counts to the process totals and clears them.
+void flush_profile(ProfileCounts& counts);
 
-    // Initializes all necessary data structures and settings for the analysis.
-    // This includes setting up draw statistics lists, ordinal branches, and initial configurations.
-    void init_all();
+// One per thread; folds itself into the process totals when its thread exits.
+struct ProfileThreadCounts : ProfileCounts {
+    ~ProfileThreadCounts() { flush_profile(*this); }
+};
+extern thread_local ProfileThreadCounts _profileThread;
 
-    // Sorts all ordinal lists within the linked ordinalBranch structure by average or other statistical metrics.
-    void sort_ordinal_lists();
+class ProfileScope
+{
+// Times the enclosing scope as one call of 'phase'.
+public:
+    explicit ProfileScope(ProfilePhase phase) : _phase(static_cast<int>(phase)), _start(std::chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        _profileThread.phaseNanos[_phase] += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+        _profileThread.phaseCalls[_phase]++;
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
 
-    // Analyzes all draw events from a historical draw file, updating statistics, recording opportunities, and sorting lists as needed.
-    void analyse_all_draws();
+private:
+    int _phase;
+    std::chrono::steady_clock::time_point _start;
+};
 
-    // Calculates and records the statistical event for a specific ordinal position within the ordinal branches.
-    // This function propagates updates through the branches and creates new branches if necessary.
-    void calculate_ordinal_event(int ordinance, OrdinalBranchNode*&);
+// Starts the hardware counters (cycles and cache misses of every thread) where perf_event_open is available.
+void start_profile_hardware();
+
+// Prints the profile report: phase times, counters, allocations and the hardware counters.
+void report_profile(std::ostream& out);
+
+#define PROFILE_JOIN_(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_(a, b)
+#define PROFILE_SCOPE(phase) ProfileScope PROFILE_JOIN(_profileScope, __LINE__)(ProfilePhase::phase)
+#define PROFILE_COUNT(counter, amount) (_profileThread.counters[static_cast<int>(ProfileCounter::counter)] += static_cast<uint64_t>(amount))
+#define PROFILE_ALLOCATED(subsystem, bytes) (_profileThread.allocatedBytes[static_cast<int>(ProfileMemory::subsystem)] += static_cast<uint64_t>(bytes))
+#define PROFILE_ONLY(statement) statement
+#else
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+#define PROFILE_ALLOCATED(subsystem, bytes) ((void)0)
+#define PROFILE_ONLY(statement)
+#endif
 
-    // Records an opportunity for a specific ordinal position within the ordinal branches, 
-    // particularly when the number wasn't drawn but could have been.
-    void record_ordinal_opportunity(int ordinance, OrdinalBranchNode*&);
+// Counts the new block of 'items' when a reallocation changed its capacity from 'capacityBefore'.
+#define PROFILE_GROWTH(subsystem, items, capacityBefore) \
+    PROFILE_ALLOCATED(subsystem, (items).capacity() != (capacityBefore) ? (items).capacity() * sizeof(*(items).data()) : 0)
 
-    // Correlates data across ordinal branches, starting from the last branch and propagating statistical calculations (like averages) backwards.
-    // Future versions may include more statistical metrics such as sigma and standard deviation.
-    void correlate_data();
+/* Logging.
+Records are cheap to make: a record is the level, a pointer to a constant format string and up to four
+integers, pushed into a fixed lock-free ring buffer. A background thread drains the ring, formats the
+records (each "{}" in the format takes the next integer) and writes them to stderr in batches, so a
+thread that logs never formats, locks or flushes. When the ring is full the record is dropped and counted.
+Levels below RA_LOG_LEVEL (0 trace, 1 debug, 2 info, 3 warning, 4 error) are compiled out; the
+others are filtered at run time by the logger's level (the logLevel config key).*/
 
-    // Calculates and records a draw event for a specific number, updating its statistics such as total times drawn and average.
-    // Designed to be extendable for additional calculations in the future.
-    void calculate_draw_event(DrawStatisticNode*&);
+#ifndef RA_LOG_LEVEL
+#define RA_LOG_LEVEL 0
+#endif
 
-    // Propagates statistical calculations through the ordinal branches, updating nodes and transferring final sums to the draw numbers.
-    // Handles recursive propagation and ensures the correct statistical metrics are updated.
-    void propagate_statistical_tree(int ordinance, double ordinalSum, OrdinalBranchNode*&);
+struct LogRecord {
+    LogLevel level;
+    const char *format;      // A string literal; "{}" marks where the next argument goes.
+    int argumentCount;
+    long long arguments[4];
+};
 
-    // Sorts the linked list of draw statistics based on the average value of each draw number.
-    // Uses a bubble sort algorithm and is designed to be easily extended to sort by other metrics.
-    void sort_draws_average();
+class LogRing
+{
+/* Bounded multi-producer, single-consumer ring of log records.
+Each slot carries a sequence number that tells producers and the consumer whose turn it is, so
+push and pop are a compare-and-swap on a shared index plus a copy, without any lock.*/
+public:
+    // 'capacity' is rounded up to a power of two.
+    explicit LogRing(size_t capacity);
+
+    // Appends a record; returns false when the ring is full.
+    bool push(const LogRecord& record);
+
+    // Removes the oldest record; returns false when the ring is empty. Only the drain thread pops.
+    bool pop(LogRecord& record);
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+    std::unique_ptr<Slot[]> _slots;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _enqueue;
+    alignas(64) std::atomic<size_t> _dequeue;
+};
 
-    // Sorts the ordinal list within a given ordinal branch by average or other statistical metrics.
-    // Currently sorts by average but can be extended to include other criteria.
-    void sort_ordinal_average(OrdinalBranchNode*&);
+class Logger
+{
+/* The process logger: the ring, its drain thread and the run-time level.
+The drain thread starts with the first record; the logger drains and stops when the program exits.*/
+public:
+    Logger();
+    ~Logger() { stop(); }
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // Records at 'level' or above are kept.
+    void set_level(LogLevel level) { _level.store(static_cast<int>(level), std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return static_cast<int>(level) >= _level.load(std::memory_order_relaxed); }
+
+    // Queues a record for the drain thread.
+    template <class... Arguments>
+    void write(LogLevel level, const char *format, Arguments... arguments) {
+        static_assert(sizeof...(Arguments) <= 4, "a log record holds at most four arguments");
+        LogRecord record = {level, format, static_cast<int>(sizeof...(Arguments)), {static_cast<long long>(arguments)...}};
+        if (!_started.load(std::memory_order_acquire)) start();
+        if (!_ring.push(record)) _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
 
+    // Writes every queued record and stops the drain thread.
+    void stop();
+
+private:
+    void start();
+    void drain_loop();
+    size_t drain(std::string& text);
+
+    LogRing _ring;
+    std::atomic<int> _level;
+    std::atomic<bool> _started;
+    std::atomic<bool> _stopping;
+    std::atomic<unsigned long long> _dropped;
+    std::mutex _startLock;
+    std::thread _drainer;
+};
 
-    // Initializes a linked list of ordinalListNode elements in sequential order, setting up the ordinal positions and default statistics.
-    // Memory allocation is checked, and the list is terminated properly.
-    void initialize_ordinal_list(OrdinalStatisticNode*&);
+extern Logger _log;
 
-    // Loads the configuration from a file into the provided Config object.
-    // Returns true if the configuration is successfully loaded, false otherwise.
-    bool load_config(const string& configFilePath, Config&);
+#define RA_LOG(level, ...) \
+    do { if (static_cast<int>(level) >= RA_LOG_LEVEL && _log.enabled(level)) _log.write(level, __VA_ARGS__); } while (0)
+#define LOG_TRACE(...) RA_LOG(LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...) RA_LOG(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) RA_LOG(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) RA_LOG(LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) RA_LOG(LogLevel::Error, __VA_ARGS__)
 
-    // Function to open and validate the draw history file, count the total number of draws,
-    // and perform initial validation checks on the draw data.
-    // This function ensures that the file is properly opened and each draw has the correct
-    // number of entries, and that the draw numbers are within the expected range.
-    // Returns an ifstream object that is positioned at the start of the file, ready for further processing.
-    // If the file cannot be opened or a validation error occurs, the function will handle the error and return an invalid ifstream object.
-    ifstream collect_census();
+class ThreadPool
+{
+/* A fixed set of worker threads that run queued jobs.
+Jobs are plain callables; submit() queues one and wait() blocks until every queued job has finished.
+The pool is shared by the parallel engines (combination generation, scoring, sweeps) so that
+threads are created once instead of per task.*/
+public:
+    // Starts 'threads' workers; 0 starts one per available core.
+    explicit ThreadPool(unsigned threads = 0);
 
-    // Function to extract a draw from a line of text in the draw history file.
-    // Takes a string (line) as input and returns a DrawMatrix containing the parsed draw numbers.
-    DrawSet extract_draw_vector(const std::string& line);
+    // Finishes the queued jobs and joins the workers.
+    ~ThreadPool();
 
-    // Function to process a single draw vector, updating statistics and events.
-    // Takes a vector of integers (representing a single draw) as input.    
-    void process_draw_vector(DrawSet);
+    // Queues a job to run on the next idle worker.
+    void submit(std::function<void()> job);
 
-    // Function to reset flags and other state indicators after processing a draw.
-    // This is typically used to reset the `isDrawn` flags in the draw statistics list.
-    void reset_flags(); 
+    // Blocks until the queue is empty and no worker is running a job.
+    void wait();
 
-    // Function to collect the remaining draws for testing purposes.
-    // Reads from the specified draw index in the file and stores them in `_remainingDraws`.
-    void collect_remaining_draws(ifstream& file, int startDraw); 
+    // Number of worker threads in the pool.
+    unsigned size() const { return static_cast<unsigned>(_workers.size()); }
 
-	bool validate_draw_combination(Card);
-	bool prime_number_check(Card);
-	void create_all_combinations();
+private:
+    void worker_loop();
 
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _jobs;
+    std::mutex _lock;
+    std::condition_variable _jobReady;
+    std::condition_variable _allDone;
+    unsigned _running = 0;
+    bool _stopping = false;
+};
 
+class SpscQueue
+{
+/* Bounded single-producer, single-consumer queue of ints (indexes of work items held elsewhere).
+The producer only writes the tail and the consumer only writes the head, so push and pop are one
+load, one store and one release of an index. A full or empty queue is waited out by yielding.*/
+public:
+    // 'capacity' is rounded up to a power of two.
+    explicit SpscQueue(size_t capacity);
 
-	struct ValidCombinationList{
+    // Appends a value, waiting while the queue is full. Only the producer pushes.
+    void push(int value);
 
-		char _validCombination[_drawCardSize];
-		struct ValidCombinationList *_next;
-	};
-	std::vector<ValidCombinationList> _validCombination;
+    // Removes the oldest value, waiting while the queue is empty. Only the consumer pops.
+    int pop();
 
-	
-   // Pointer to the start of the linked list that holds statistics for each draw number.
-    // This list keeps track of various statistics like total times drawn, opportunities, and averages.
-    DrawStatisticNode *_drawTreeStart;
+private:
+    std::unique_ptr<int[]> _slots;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+};
 
-    // Pointer to the start of the linked list of ordinal branches.
-    // Each branch contains a list of ordinal positions and related statistical data.
-    OrdinalBranchNode *_ordinalTreeStart;
+struct OrdinalPipelineDraw {
+// One draw in flight through the ordinal pipeline.
+    OrdinalDrawBatch batch;         // The draw's updates, as process_draw collected them.
+    OrdinalLevelStream stream;      // How far down the tree the draw has got.
+    bool seeded;                    // Whether the draw reaches the ordinal tree at all; before that only the recency statistics close it.
+};
 
+struct OrdinalPipeline {
+/* State shared by the ingest thread and the stages of pipelined ingest (see Analyse::analyse_draws_pipelined).
+Stage s owns the levels from firstLevel[s] up to firstLevel[s + 1]; the last stage owns every level after
+its first. Draws travel as indexes into 'draws': the ingest thread hands one to stage 0 through queues[0],
+each stage hands it on through the next queue, and the last stage gives it back through 'returned'.*/
+
+    int stages = 0;
+    int initialLevels = 0;                          // Levels in the tree when the pipeline started.
+    std::vector<int> firstLevel;                    // First level of each stage.
+    std::vector<OrdinalPipelineDraw> draws;         // Draws that can be in flight at once.
+    int unused = 0;                                 // Draws not handed out yet; later ones come back through 'returned'.
+    std::vector<std::unique_ptr<SpscQueue>> queues; // queues[s] feeds stage s.
+    std::unique_ptr<SpscQueue> returned;            // Draws the last stage has finished.
+};
 
-    // Pointer to the start of the linked list that holds valid combinations.
-    // This list contains valid combinations of numbers or other relevant data, typically used for analysis.
-    ValidCombinationList *_validCombinationsStart;
+class MappedFile
+{
+/* A read-only view of a whole file.
+The file is memory mapped where the platform supports it, so attaching costs nothing until pages
+are touched; elsewhere it is read into a buffer once. Either way data()/size() expose the bytes.*/
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps (or reads) the file; returns false if it cannot be opened.
+    bool open(const char *path);
+
+    // Releases the mapping.
+    void close();
+
+    bool is_open() const { return _data != nullptr; }
+    const char *data() const { return _data; }
+    size_t size() const { return _size; }
+
+    // Device and inode of the opened file folded together, to tell a file replaced under the same path; 0 where unknown.
+    uint64_t identity() const { return _identity; }
+
+private:
+    const char *_data = nullptr;
+    size_t _size = 0;
+    uint64_t _identity = 0;
+    bool _mapped = false;
+    std::vector<char> _buffer;
+};
 
-    // Tracks the total number of draw events that have been processed.
-    // This counter is incremented each time a new draw is processed and is used for various calculations.
-    int _drawHistoryTotal;
+class BufferedFile
+{
+/* A write-only file with a large buffer in front of it.
+Text and bytes are appended to the buffer and handed to the OS a block at a time, so an export
+costs a handful of write calls however many fields it holds. Numbers are formatted with
+std::to_chars: no locale, no stream state, and floating-point values read back exactly.*/
+public:
+    BufferedFile() = default;
+    ~BufferedFile() { close(); }
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+    // Creates (or truncates) the file; returns false if it cannot be opened.
+    bool open(const char *path);
+
+    // Writes out the buffer and closes the file; returns false if any write failed.
+    bool close();
+
+    void text(const char *value) { _buffer += value; }
+    void character(char value) { _buffer += value; }
+    void bytes(const void *data, size_t size) { _buffer.append(static_cast<const char *>(data), size); commit(); }
+
+    // Appends the shortest decimal text that reads back as 'value'.
+    template <class Number>
+    void number(Number value) {
+        char digits[32];
+        auto converted = std::to_chars(digits, digits + sizeof(digits), value);
+        _buffer.append(digits, converted.ptr);
+    }
 
-    // Tracks the total number of valid combination cards that have been processed.
-    // This variable is incremented as valid combinations are identified and added to the list.
-    int _totalValidCombinationCards;
+    // Ends a row: appends a newline and writes the buffer out once it holds a full block.
+    void end_row() { _buffer += '\n'; commit(); }
 
-    // Tracks the total number of ordinal branch nodes in the linked list.
-    // This counter helps in managing and navigating the structure of ordinal branches.
-    int _ordinalBranchTotalNodes;
+private:
+    void commit() { if (_buffer.size() >= (1 << 20)) flush(); }
+    void flush();
 
-   
+    FILE *_file = nullptr;
+    std::string _buffer;
+    bool _failed = false;
+};
 
-    // Holds the file path for the draw history file, which contains past draw events.
-    // This file is used to load historical draw data for analysis.
-    char _drawHistoryFile[50];
+// Version of the card validation rules in validate_card_mask.
+// Bump it whenever a rule changes so stale combination index files are rebuilt.
+const uint32_t _combinationFilterVersion = 1;
+
+struct CombinationIndexHeader {
+/* Header at the start of a combination index file.
+The file holds one validity bit per card, in colex rank order, followed by an optional packed
+list of the ranks of the valid cards. The colex rank of a card with numbers c1 < c2 < ... < c7 is
+C(c1-1,1) + C(c2-1,2) + ... + C(c7-1,7), so ranks run from 0 to C(49,7)-1 without gaps.*/
+
+    char magic[8];            // "RACOMBIX".
+    uint32_t formatVersion;   // Layout version of this file (currently 1).
+    uint32_t filterVersion;   // _combinationFilterVersion of the rules the bitset was built with.
+    uint32_t drawRange;       // Numbers in the game (49).
+    uint32_t cardSize;        // Numbers per card (7).
+    uint64_t totalCards;      // C(drawRange, cardSize): the number of bits in the bitset.
+    uint64_t validCards;      // Number of set bits.
+    uint64_t bitsetOffset;    // Byte offset of the bitset (64-bit words, bit r = rank r).
+    uint64_t rankListOffset;  // Byte offset of the packed valid rank list (uint32 each), or 0 when absent.
+};
 
-    // Holds the file path for the combination collection file, which contains combinations to be analyzed.
-    // This file is used to load a collection of combinations for validation and further analysis.
-    char _combinationCollectionFile[50];
+class CombinationIndex
+{
+/* Read-only access to a combination index file.
+Attaching maps the file and checks its header against the current game geometry and filter version;
+after that every query is a couple of array accesses and no parsing ever happens.*/
+public:
+    CombinationIndex();
 
-    // Boolean flag to enable or disable debug mode.
-    // When set to true, additional debug information is output to help trace the program's execution.
-    bool _debugMode;
+    // Maps the index file; returns false if it is missing, damaged or built for other rules.
+    bool attach(const char *path);
+    void detach();
+    bool is_attached() const { return _header != nullptr; }
 
-    // Flag indicating whether the application is in test mode.
-    // If true, only a subset of draws will be processed, leaving the rest for testing.
-    bool _loadTest; 
+    uint64_t total_cards() const { return _header ? _header->totalCards : 0; }
+    uint64_t valid_cards() const { return _header ? _header->validCards : 0; }
 
-    // Flag indicating whether the initial seed of draw events has been completed.
-    // This is used to determine when to start calculating ordinal events.
-    bool _seeded; 
+    // Whether the card with the given colex rank passed validation.
+    bool is_valid_rank(uint64_t rank) const { return (_bits[rank >> 6] >> (rank & 63)) & 1; }
 
-    // Counter to track the total number of draw events processed.
-    // This includes all draws analyzed during the execution of the program.
-    int _totalEvents; 
+    // Whether a card (numbers in ascending order) passed validation.
+    bool is_valid(const int *card) const { return is_valid_rank(rank_of(card)); }
 
-    // A matrix (vector of vectors) storing the draws reserved for testing.
-    // Each inner vector represents a single draw's ball numbers.
-    DrawMatrix _remainingDraws; 
+    // Colex rank of a card whose numbers are in ascending order.
+    uint64_t rank_of(const int *card) const;
 
-    // A matrix (vector of vectors) storing the most recent draws processed.
-    // Used to track and analyze the latest draw events.
-    DrawMatrix _lastDraw; 
+    // Writes the card with the given colex rank to 'card' in ascending order.
+    void card_at(uint64_t rank, int *card) const;
 
-    // The number of draws to reserve for testing purposes.
-    // This value can be adjusted based on the needs of the test scenario.
-    int _testDrawCount = 100; 
+    // The packed list of valid ranks, when the file carries it.
+    bool has_rank_list() const { return _ranks != nullptr; }
+    uint64_t valid_rank_at(uint64_t index) const { return _ranks[index]; }
 
+private:
+    MappedFile _file;
+    const CombinationIndexHeader *_header = nullptr;
+    const uint64_t *_bits = nullptr;
+    const uint32_t *_ranks = nullptr;
+    uint64_t _binomial[_drawRange + 1][_drawCardSize + 1]; // _binomial[n][k] = C(n, k).
 };
 
+struct ScoredCard {
+/* One card and its score, as reported by the scoring engine.
+The card is identified by its colex rank (see CombinationIndexHeader); the numbers are filled in
+only for the cards that make it into the final report.*/
 
-void Analyse::init_all() {
-// Function to initialize all necessary data structures and settings for the analysis.
+    double score;                  // Combined weight of the card's numbers.
+    uint64_t rank;                 // Colex rank of the card.
+    int balls[_drawCardSize];      // The card's numbers in ascending order.
+};
 
-    // Initialize the linked list for draw number statistics.
-    _drawTreeStart = new DrawStatisticNode;
-    if (!_drawTreeStart) {
-        cerr << "[Error] Failed to allocate memory for _drawNumbersStart." << endl;
-        return; // Consider more graceful error handling in production code.
-    }
-    _lastDraw.push_back(DrawSet(_drawCardSize, 0)); // Initialize a new draw set in _lastDraw if needed
-    DrawStatisticNode *currentDrawNumber = _drawTreeStart;
-    int ballValue = 0;
-    int _totalEvents = 0;
-
-    // Loop to initialize each draw number's statistics.
-    while (ballValue < _drawRange) {
-        // Initialize the current node's data.
-        currentDrawNumber->totalTimesDrawn = 0;
-        currentDrawNumber->drawNumber = ballValue + 1; // Assign draw number.
-        currentDrawNumber->isDrawn = false;
-        currentDrawNumber->drawOpportunities = 0;
-        currentDrawNumber->average = 0.0;
-        currentDrawNumber->lastDrawn = 0;
-        currentDrawNumber->ordinalChance = 0.0;
-
-        ballValue++;
-
-        // Check if we've reached the last draw number.
-        if (ballValue == _drawRange) {
-            currentDrawNumber->_next = nullptr; // End the list.
-            break;
-        }
+struct CardScoreReport {
+/* Result of scoring every valid combination: the best and the worst cards with their scores.
+Ties are broken by colex rank (lower rank first), so the report does not depend on the thread count.*/
 
-        // Allocate memory for the next node in the list.
-        currentDrawNumber->_next = new DrawStatisticNode;
-        if (!currentDrawNumber->_next) {
-            cerr << "[Error] Failed to allocate memory for the next DrawNumberStatistics node." << endl;
-            currentDrawNumber->_next = nullptr;
-            break; // Exit the loop if memory allocation fails.
-        }
+    std::vector<ScoredCard> best;  // Highest scores first.
+    std::vector<ScoredCard> worst; // Lowest scores first.
+    uint64_t scoredCards = 0;      // Number of valid cards that were scored.
+    double seconds = 0.0;          // Wall time of the scoring run.
+};
 
-        // Move to the next node.
-        currentDrawNumber = currentDrawNumber->_next;
-    }
+struct BacktestSplit {
+/* Walk-forward result at one split point: the analyzer was trained on the draws before 'split'
+and then scored the 'evaluated' draws that follow it without learning from them.
+Every metric is kept for both rankings: index 0 ranks the balls by ordinalChance, index 1 by average.*/
 
-    // Initialize other necessary members.
-    _totalValidCombinationCards = 0; // Initialize the count of valid combination cards.
+    int split;                     // Number of draws trained on.
+    int evaluated;                 // Number of draws scored after the split.
+    double hits[2];                // Mean number of drawn balls per draw that were ranked in the top N.
+    double meanRank[2];            // Mean rank (1 = best) of the drawn balls.
+    double logLoss[2];             // Mean binary log-loss of the per-ball draw probabilities, per draw.
+};
 
-    // Initialize the ordinal branch structure.
-    _ordinalTreeStart = new OrdinalBranchNode;
-    // Set initial values for the ordinal branch.
-    _ordinalTreeStart->sampleSize = 0;
-    _ordinalTreeStart->_previous = nullptr;
-    _ordinalTreeStart->_next = nullptr;
-	
-    _ordinalTreeStart->listNode = new OrdinalStatisticNode;
-    // Initialize the first ordinal list.
-    initialize_ordinal_list(_ordinalTreeStart->listNode);
+struct SweepParameters {
+/* One configuration of the runtime analyzer parameters explored by a parameter sweep.*/
 
-    // Initialize other relevant counters and flags.
-    _drawHistoryTotal = 0;
-    _ordinalBranchTotalNodes = 1;
-    _debugMode = true;
-}
+    int drawSampleSize;            // Analyse::_drawSampleSize.
+    int ordinalSampleSize;         // Analyse::_ordinalSampleSize.
+    int testDrawCount;             // Analyse::_testDrawCount: the holdout at the end of the history.
+};
 
-void Analyse::display_draw_statistics() {
-/* Function to display the draw statistics for each number.
- This function iterates through the linked list of draw statistics, 
- starting from _drawNumbersStart, and prints out the relevant information 
- for each draw number.*/
+struct SweepResult {
+/* Result of one sweep configuration: the analyzer trained on the history minus the holdout,
+and the holdout scored against it (see BacktestSplit).*/
 
-    // Start with the first draw number in the linked list.
-	DrawStatisticNode* currentDraw;
-	currentDraw = _drawTreeStart;
+    SweepParameters parameters;    // The configuration that was run.
+    int ordinalLevels;             // Depth of the ordinal tree after training, retired levels included.
+    BacktestSplit holdout;         // Holdout metrics; holdout.split is the number of draws trained on.
+    double seconds;                // Wall time of this configuration.
+};
 
-    // Print the header for the statistics display.
-    std::cerr << "Draw Statistics (sorted by average):" << std::endl;
+struct NullStatistic {
+/* Running comparison of one statistic of the real history against its null distribution.
+Every simulated value is compared with the real value as it arrives, so the percentile of the
+real value is known without keeping the simulated values; the sums give the null mean and spread.*/
+
+    long long samples = 0;         // Simulated histories that produced this statistic.
+    long long below = 0;           // Simulated values below the real value.
+    long long equal = 0;           // Simulated values equal to the real value.
+    double sum = 0.0;              // Sum of the simulated values.
+    double sumSquares = 0.0;       // Sum of their squares.
+
+    void add(double simulated, double real) {
+        samples++;
+        below += simulated < real;
+        equal += simulated == real;
+        sum += simulated;
+        sumSquares += simulated * simulated;
+    }
+    void merge(const NullStatistic& other) {
+        samples += other.samples;
+        below += other.below;
+        equal += other.equal;
+        sum += other.sum;
+        sumSquares += other.sumSquares;
+    }
+    double mean() const { return samples ? sum / samples : 0.0; }
+    double deviation() const { return samples ? sqrt(std::max(0.0, sumSquares / samples - mean() * mean())) : 0.0; }
+    // Percentile of the real value in the null distribution (ties count half).
+    double percentile() const { return samples ? 100.0 * (below + 0.5 * equal) / samples : 0.0; }
+};
 
-    // Iterate through the linked list of draw statistics.
-	while(currentDraw != nullptr)
-	{
-        // Output the statistics for the current draw number.
-        std::cerr << "Draw Number: " << currentDraw->drawNumber          // The draw number being reported.
-                  << " Total Drawn: " << currentDraw->totalTimesDrawn    // The total number of times this number has been drawn.
-                  << " Opportunities: " << currentDraw->drawOpportunities// The number of opportunities this number had to be drawn.
-                  << " Average: " << currentDraw->average                // The average position of this number in all draws.
-				  << " Ordinal Chance: " << currentDraw->ordinalChance    // The calculated chance of this number being drawn in its ordinal position.
-                  << " Last Drawn: " << currentDraw->lastDrawn << std::endl; // The last draw number in which this number was drawn.
-
-        // Move to the next draw number in the linked list.
-		currentDraw = currentDraw->_next;
-	}
-}
+struct NullDistributionReport {
+/* Result of a Monte Carlo run: the real history's per-ball and per-level statistics placed in the
+null distributions obtained from uniform synthetic histories of the same length.*/
+
+    long long simulations = 0;                        // Synthetic histories analysed.
+    int historyLength = 0;                            // Draws per synthetic history.
+    double realOrdinalChance[_drawRange] = {};        // Real per-ball ordinalChance.
+    double realAverage[_drawRange] = {};              // Real per-ball average.
+    int firstLevel = 1;                               // Number (from 1) of the first live level; the levels below it are retired.
+    int realLevels = 0;                               // Real tree depth, retired levels included.
+    std::vector<double> realLevelSpread;              // Real spread (highest - lowest average) of each live ordinal level, from firstLevel.
+    NullStatistic ordinalChance[_drawRange];          // Null distribution of each ball's ordinalChance.
+    NullStatistic average[_drawRange];                // Null distribution of each ball's average.
+    std::vector<NullStatistic> levelSpread;           // Null distribution of each level's spread, over the histories that reach it live.
+    NullStatistic levels;                             // Null distribution of the tree depth, retired levels included (real value: realLevels).
+    double seconds = 0.0;                             // Wall time of the run.
+};
 
-void Analyse::display_ordinal_lists() {
-// Function to display the ordinal lists for each branch in the ordinal branch structure.
-// This function iterates through the linked list of ordinal branches, starting from _ordinalBranchStart,
-// and prints out the relevant information for each ordinal list at each level.
+struct BacktestReport {
+/* Result of a walk-forward backtest over many split points of the draw history.*/
 
-    // Start with the first ordinal branch in the linked list.
-    OrdinalBranchNode* currentBranch;
-    currentBranch = _ordinalTreeStart;
-    int OrdinalLevel = 1; // Track the rank of the ordinal branch list (starting from 1).
+    int topN = 0;                  // Size of the top-N list used for the hit counts.
+    int horizon = 0;               // Draws scored after each split.
+    std::vector<BacktestSplit> splits; // One entry per split point, in history order.
+    double seconds = 0.0;          // Wall time of the backtest.
+};
 
-    // Iterate through the linked list of ordinal branches.
-    while(currentBranch != NULL)
-    {
-        // Print the level and sample size for the current ordinal branch.
-        std::cerr << "Ordinal Level " << OrdinalLevel << " sample size: " << currentBranch->sampleSize << " List:" << std::endl;
-        
-        // Start with the first ordinal list node in the current branch.
-        OrdinalStatisticNode* currentOrdinal = currentBranch->listNode;
+template <class Before>
+class BoundedCardHeap
+{
+/* Keeps the 'capacity' cards that come first under the ordering 'Before'.
+The cards are held as a binary heap whose root is the kept card that comes last, so a new card
+is compared against the root once and only cards that beat it touch the heap.*/
+public:
+    explicit BoundedCardHeap(size_t capacity) : _capacity(capacity) { _cards.reserve(capacity); }
 
-        // Iterate through the linked list of ordinal list nodes in the current branch.
-        while (currentOrdinal != nullptr) {
-            // Output the statistics for the current ordinal.
-            std::cerr << "  Ordinal: " << currentOrdinal->ordinal          // The ordinal position being reported.
-                    << " Average: " << currentOrdinal->average            // The average probability for this ordinal position.
-                    << " Landed Total: " << currentOrdinal->landedTotal   // The total number of times a number has landed in this ordinal position.
-                    << " Opportunities: " << currentOrdinal->opportunities << std::endl; // The number of opportunities this ordinal position had.
+    // Whether a card with this score and rank would be kept.
+    bool admits(double score, uint64_t rank) const {
+        if (_cards.size() < _capacity) return true;
+        return _capacity && _before(ScoredCard{score, rank, {}}, _cards.front());
+    }
 
-            // Move to the next ordinal list node in the current branch.
-            currentOrdinal = currentOrdinal->_next;
+    // Offers a card to the heap; it is kept if it beats the card that currently comes last.
+    void push(const ScoredCard& card) {
+        if (!admits(card.score, card.rank)) return;
+        if (_cards.size() == _capacity) {
+            std::pop_heap(_cards.begin(), _cards.end(), _before);
+            _cards.pop_back();
         }
+        _cards.push_back(card);
+        std::push_heap(_cards.begin(), _cards.end(), _before);
+    }
 
-        std::cerr << std::endl; // Print a newline for readability between levels.
-
-        // Move to the next ordinal branch in the linked list.
-        currentBranch = currentBranch->_next;
-        OrdinalLevel++; // Increment the ordinal level counter.
+    // The kept cards in order, best first.
+    std::vector<ScoredCard> sorted() const {
+        std::vector<ScoredCard> cards = _cards;
+        std::sort(cards.begin(), cards.end(), _before);
+        return cards;
     }
-}
 
-void Analyse::sort_draws_average() {
-/* Function to sort the linked list of draw statistics based on the 'average' field.
-   This function uses a modified bubble sort algorithm to arrange the draw numbers
-   in ascending order of their average draw position. */
-
-    bool swapped; // Flag to track if any swaps were made during the iteration.
-    DrawStatisticNode *ptr1; // Pointer used to traverse the list.
-    DrawStatisticNode *lptr = nullptr; // Pointer to mark the end of the unsorted portion of the list.
-
-    // Repeat the sorting process until no swaps are made (i.e., the list is sorted).
-    do {
-        swapped = false;
-        ptr1 = _drawTreeStart; // Start from the beginning of the list.
-
-        // Traverse the list until the last sorted element (lptr).
-        while (ptr1->_next != lptr) {
-            // Compare the average of the current node with the next node.
-            if (ptr1->average > ptr1->_next->average) {
-                // If the current node's average is greater, swap the entire contents of the nodes.
-                std::swap(ptr1->totalTimesDrawn, ptr1->_next->totalTimesDrawn);
-                std::swap(ptr1->drawNumber, ptr1->_next->drawNumber);
-                std::swap(ptr1->isDrawn, ptr1->_next->isDrawn);
-                std::swap(ptr1->drawOpportunities, ptr1->_next->drawOpportunities);
-                std::swap(ptr1->average, ptr1->_next->average);
-                std::swap(ptr1->lastDrawn, ptr1->_next->lastDrawn);
-				std::swap(ptr1->ordinalChance, ptr1->_next->ordinalChance);
-                
-                swapped = true; // Indicate that a swap was made.
-            }
-            ptr1 = ptr1->_next; // Move to the next node in the list.
-        }
+private:
+    size_t _capacity;
+    std::vector<ScoredCard> _cards;
+    Before _before;
+};
 
-        // Mark the end of the sorted portion of the list.
-        lptr = ptr1;
-
-    // Continue the process as long as swaps are being made.
-    } while (swapped);
-}
-
-void Analyse::sort_ordinal_average(OrdinalBranchNode*& Head) {
-/* Function to sort the ordinal list within a given ordinal branch based on the 'average' field.
-This function uses a modified bubble sort algorithm to arrange the ordinal list nodes
-in ascending order of their average probability values. */
-
-    // If the head of the ordinal branch is null, there is nothing to sort.
-    if (Head == nullptr) return;
-
-    bool swapped; // Flag to track if any swaps were made during the iteration.
-    OrdinalStatisticNode *ptr1; // Pointer used to traverse the list.
-    OrdinalStatisticNode *lptr = nullptr; // Pointer to mark the end of the unsorted portion of the list.
-
-    // Repeat the sorting process until no swaps are made (i.e., the list is sorted).
-    do {
-        swapped = false;
-        ptr1 = Head->listNode; // Start from the beginning of the ordinal list.
-
-        // Traverse the list until the last sorted element (lptr).
-        while (ptr1->_next != lptr) {
-            // Compare the average of the current node with the next node.
-            if (ptr1->average > ptr1->_next->average) {
-                // If the current node's average is greater, swap the entire contents of the nodes.
-                std::swap(ptr1->landedTotal, ptr1->_next->landedTotal);
-                std::swap(ptr1->ordinal, ptr1->_next->ordinal);
-                std::swap(ptr1->isDrawn, ptr1->_next->isDrawn);
-                std::swap(ptr1->opportunities, ptr1->_next->opportunities);
-                std::swap(ptr1->average, ptr1->_next->average);
-                std::swap(ptr1->ordinalChance, ptr1->_next->ordinalChance); // Swap ordinalChance as well.
-                
-                swapped = true; // Indicate that a swap was made.
-            }
-            ptr1 = ptr1->_next; // Move to the next node in the list.
-        }
+// Orders cards by score, highest first; ties go to the lower colex rank.
+struct HigherCardScore {
+    bool operator()(const ScoredCard& a, const ScoredCard& b) const {
+        return a.score > b.score || (a.score == b.score && a.rank < b.rank);
+    }
+};
 
-        // Mark the end of the sorted portion of the list.
-        lptr = ptr1;
+// Orders cards by score, lowest first; ties go to the lower colex rank.
+struct LowerCardScore {
+    bool operator()(const ScoredCard& a, const ScoredCard& b) const {
+        return a.score < b.score || (a.score == b.score && a.rank < b.rank);
+    }
+};
 
-    // Continue the process as long as swaps are being made.
-    } while (swapped);
-}
+// Version of the Analyse snapshot layout (see AnalyseSnapshotHeader).
+// Bump it whenever the snapshot contents or the layout of a saved struct change.
+const uint32_t _snapshotFormatVersion = 5;
+
+struct AnalyseSnapshotHeader {
+/* Header at the start of an analyzer snapshot file.
+The header is followed by the DrawStatisticTable, the CoOccurrenceTable, the RetiredOrdinalLevels summary and then 'levels'
+OrdinalBranchNode blocks (the live levels), written as they are held in memory. When recency statistics are
+kept, the recency state of the draw table and then of every live level follows (RecencyColumns, then the ring). A snapshot is only restored into the same build and game geometry, and
+only when the draws it was taken after are still the first draws of the history (historyFingerprint).*/
+
+    char magic[8];                   // "RASNAPST".
+    uint32_t formatVersion;          // _snapshotFormatVersion of the build that wrote it.
+    uint32_t drawRange;              // Numbers in the game (49).
+    uint32_t cardSize;               // Numbers per draw (7).
+    uint32_t drawSampleSize;         // Analyse::_drawSampleSize the state was built with.
+    uint32_t ordinalSampleSize;      // Analyse::_ordinalSampleSize the state was built with.
+    uint32_t drawTableBytes;         // sizeof(DrawStatisticTable).
+    uint32_t coOccurrenceBytes;      // sizeof(CoOccurrenceTable).
+    uint32_t levelBytes;             // sizeof(OrdinalBranchNode).
+    uint32_t levels;                 // Number of live ordinal levels that follow the retired summary.
+    uint32_t retiredBytes;           // sizeof(RetiredOrdinalLevels).
+    uint32_t maxLevels;              // Analyse::_ordinalGrowth the state was built with.
+    uint32_t retireSampleSize;
+    uint64_t memoryBudget;
+    uint32_t recencyWindow;          // Analyse::_recency the state was built with.
+    uint32_t ranking;
+    double recencyDecay;
+    uint32_t seeded;                 // Analyse::_seeded.
+    int32_t totalEvents;             // Analyse::_totalEvents.
+    uint64_t processedDraws;         // Position in the history: the number of draws the state holds.
+    uint64_t historyFingerprint;     // Fingerprint of those draws (see Analyse::history_fingerprint).
+    int32_t lastDraw[_drawCardSize]; // The most recent draw processed (Analyse::_lastDraw).
+};
 
-void Analyse::record_ordinal_opportunity(int ordinance, OrdinalBranchNode*& Node){
-/* Function to record an opportunity for a specific ordinal position (rank) in the linked ordinal branches.
-This is a recursive function that takes a rank position (ordinance) of a sorted list and increments the 
-opportunities count for that position if it could have been drawn but wasn't. 
-The function then propagates this opportunity recording through all linked ordinal branches, 
-ensuring that every relevant ordinal list node is updated across all levels.
+// Formats of the statistics exporters (see Analyse::export_statistics); combined as bit flags.
+enum ExportFormat : unsigned {
+    ExportCsv = 1,          // <prefix>.draws.csv and <prefix>.ordinals.csv
+    ExportJsonLines = 2,    // <prefix>.draws.jsonl and <prefix>.ordinals.jsonl
+    ExportColumns = 4       // <prefix>.columns (binary, see StatisticsColumnsHeader)
+};
 
-This function is called from within analyse_all_draws().*/
+// Version of the binary columnar export layout. Bump it whenever a column is added, removed or changes type.
+const uint32_t _columnsFormatVersion = 3;
+
+struct StatisticsColumnsHeader {
+/* Header at the start of a binary columnar statistics export. All values are little-endian.
+The header is followed by the draw block and then one block per ordinal level, in level order.
+Every column holds drawRange values indexed by slot (ball - 1 for the draw block, ordinal - 1 for a
+level block); the sorted order is in the rank column. Each block is padded to a multiple of 8 bytes.
+  Draw block:  float64 average, float64 ordinalChance, float64 ordinalSigma, int32 totalDrawn, int32 opportunities,
+               int32 lastDrawn, int32 rank.
+  Level block: int64 sampleSize, float64 average, float64 ordinalChance, int32 landedTotal,
+               int32 opportunities, int32 rank.*/
+
+    char magic[8];             // "RACOLUMN".
+    uint32_t formatVersion;    // _columnsFormatVersion.
+    uint32_t drawRange;        // Values per column.
+    uint32_t levels;           // Number of level blocks.
+    uint32_t blockAlignment;   // Blocks are padded to a multiple of this many bytes (8).
+    uint64_t processedDraws;   // Number of draws the statistics were built from.
+    uint64_t drawBlockBytes;   // Size of the draw block, padding included.
+    uint64_t levelBlockBytes;  // Size of each level block, padding included.
+    uint32_t firstLevel;       // Level number (1-based) of the first level block; the levels before it are retired.
+    uint32_t reserved;         // Zero.
+};
 
-    // Initialize pointers to traverse the current branch and its ordinal list.
-    OrdinalBranchNode* currentBranch = Node;          // Start with the provided branch (Node).
-    OrdinalStatisticNode* currentListNode = currentBranch->listNode;  // Start with the head of the ordinal list.
-    int listOrdinance = 1;  // This counter tracks the position within the current list.
+class Analyse
+{
+public:
+    // Displays statistics for all drawn numbers, including total times drawn, opportunities, and averages.
+    void display_draw_statistics();
 
-    // Traverse through the ordinal list nodes in the current branch.
-    while(currentListNode != nullptr)
-    {
-        // Check if the current node's ordinal matches the target ordinance.
-        if(currentListNode->ordinal == ordinance)
-        {
-            // This ordinal position corresponds to the one that could have been drawn but wasn't.
-            // Increment the opportunities count for this ordinal position.
-            currentListNode->opportunities++;
-
-            // Update the average probability for this ordinal position.
-            // The average is recalculated as the ratio of the times this ordinal has landed
-            // to the number of opportunities it has had.
-            currentListNode->average = static_cast<double>(currentListNode->landedTotal) 
-                                      / static_cast<double>(currentListNode->opportunities);
-
-            // If there is a subsequent ordinal branch in the linked list (_next is not nullptr),
-            // recursively call this function to propagate the opportunity recording.
-            if(Node->_next != nullptr){
-                record_ordinal_opportunity(listOrdinance, Node->_next);
-            }
+    // Displays the ordinal lists across all ordinal branches, showing each ordinal's position, average, and other statistics.
+    void display_ordinal_lists();
 
-            // Exit the recursion once the opportunity is recorded and propagated.
-            return;
-        }
-        else 
-        {
-            // Move to the next ordinal list node in the current branch.
-            currentListNode = currentListNode->_next;
-            listOrdinance++; // Increment the list ordinance counter to reflect the position.
-        }
-    }
-}
+    // Displays the 'count' most frequent pairs and triples of draw numbers next to the rate of a uniform draw.
+    void display_co_occurrence(int count);
 
-void Analyse::process_draw_vector(DrawSet draw) {
-    DrawStatisticNode* numberNode; // Pointer to traverse the linked list of draw statistics.
-    int drawCardSlot = 0;          // Counter for the position within the current draw.
-    int drawListLocation = 0;      // Location in the draw statistics list.
+    // Initializes all necessary data structures and settings for the analysis.
+    // This includes setting up draw statistics lists, ordinal branches, and initial configurations.
+    void init_all();
 
-    // Process each ball number in the draw vector
-    for (const int& ballNumber : draw) {
-        _lastDraw.back()[drawCardSlot] = ballNumber; // Store the ball number in the current draw slot of the last draw in _lastDraw
-        if (_debugMode)
-            std::cout << "[Debug] Ball " << ballNumber << " drawn in slot " << drawCardSlot << std::endl;
+    // Sorts all ordinal lists within the ordinal tree by average or other statistical metrics.
+    void sort_ordinal_lists();
 
-        numberNode = _drawTreeStart; // Start from the beginning of the draw statistics list
-        drawListLocation = 1;           // Location counter starts at 1
+    // Analyzes all draw events from a historical draw file, updating statistics, recording opportunities, and sorting lists as needed.
+    void analyse_all_draws();
+
+    // Calculates and records the statistical event for a specific ordinal position (a rank in the draw list).
+    // This function propagates updates through every level and creates a new level if necessary.
+    void calculate_ordinal_event(int ordinance);
+
+    // Records an opportunity for a specific ordinal position (a rank in the draw list) on every level, 
+    // particularly when the number wasn't drawn but could have been.
+    void record_ordinal_opportunity(int ordinance);
+
+    // Applies every ordinal event and opportunity collected in _ordinalBatch for the current draw.
+    // Each level takes the whole draw in one pass and hands it on to the next level in bulk.
+    void apply_ordinal_batch();
+
+    // Starts carrying the draw in 'batch' down the ordinal tree: fills the stream's histograms for the first live level.
+    // 'levels' is the number of levels the caller knows of; 'trackSlots' keeps the draw list rank -> slot mapping as it goes.
+    void begin_ordinal_stream(OrdinalLevelStream&, const OrdinalDrawBatch&, int levels, bool trackSlots);
+
+    // Applies the draw to the levels from stream.depth up to (not including) 'endDepth' or the last level,
+    // adding a level when the last one fills up. The stream can be picked up again from where it stopped.
+    void advance_ordinal_stream(OrdinalLevelStream&, const OrdinalDrawBatch&, int endDepth);
+
+    // Analyses draws [first, last) of the draw array with the ordinal tree split into contiguous groups of levels,
+    // one per pipeline stage thread (_pipelineThreads - 1 of them), while this thread keeps the draw list.
+    void analyse_draws_pipelined(int first, int last);
+
+    // Hands the draw process_draw has just collected to the first stage of the pipeline (_pipeline).
+    void submit_pipeline_draw();
+
+    // Runs stage 'stage' of the pipeline: applies each draw to its levels, hands it on, then closes and sorts its levels.
+    void run_ordinal_stage(OrdinalPipeline&, int stage);
+
+    // Correlates data across ordinal branches, starting from the last branch and propagating every OrdinalMetric backwards
+    // one pass per level, into the levels' ordinalChance and the draw numbers' ordinalChance and ordinalSigma.
+    void correlate_data();
+
+    // Calculates and records a draw event for a specific number (ball index), updating its statistics such as total times drawn and average.
+    // Designed to be extendable for additional calculations in the future.
+    void calculate_draw_event(int ball);
+
+    // Adds a draw to the pair and triple counts (_coOccurrence).
+    void record_co_occurrence(const DrawRecord& draw);
+
+    // Averages of a pair and a triple (balls 0-based, in any order): the draws that held the whole group over the draws recorded.
+    double pair_average(int a, int b) const;
+    double triple_average(int a, int b, int c) const;
+
+    // The 'count' pairs or triples drawn most often, best first; ties go to the group with the lower colex rank.
+    std::vector<GroupStatistic> top_pairs(int count) const;
+    std::vector<GroupStatistic> top_triples(int count) const;
+
+    // Pair and triple contribution to the score of the card holding the 'count' numbers (1-based) in 'balls'.
+    CardGroupScore card_group_score(const int *balls, int count) const;
+
+    // Sorts the draw list (the rank -> ball permutation) based on the average value of each draw number.
+    // Re-ranks incrementally by local insertion; the average is the lifetime, windowed or decayed one (_recency.ranking).
+    void sort_draws_average();
+
+    // Sorts the ordinal list within a given ordinal branch by the given averages (indexed by ordinal).
+    void sort_ordinal_average(OrdinalBranchNode&, const double *average);
+
+    // The averages the draw list and ordinal level 'level' (arena index) are ranked by, as chosen by _recency.ranking.
+    const double *draw_ranking_average() const;
+    const double *ordinal_ranking_average(size_t level) const;
+
+    // Closes the current draw in the recency statistics of the draw table and of every live level.
+    void close_recency_draw();
+
+    // Restores the ascending order of a rank permutation after the keys of its entries have changed.
+    // Each out-of-place entry is moved to its new rank by local insertion and the inverse index is kept up to date.
+    // Ties keep their previous order, so the result matches a full stable sort.
+    template <class KeyOf>
+    void rerank_by_insertion(int *ranked, int *rankOf, int size, KeyOf keyOf);
+
+
+    // Initializes the 49 slots of an ordinal level in sequential order, setting up the rank indexes and default statistics.
+    void initialize_ordinal_list(OrdinalBranchNode&);
+
+    // Appends a freshly initialized level to the end of the ordinal tree arena and returns its index.
+    int add_ordinal_level();
+
+    // Bytes one live ordinal level occupies: its block plus its recency statistics, when they are kept.
+    size_t ordinal_level_bytes() const;
+
+    // Whether the growth policy (_ordinalGrowth) allows one more level.
+    bool ordinal_tree_can_grow() const;
+
+    // Most live levels the growth policy allows at once; 0 when it does not limit them.
+    size_t ordinal_live_level_limit() const;
+
+    // Freezes the oldest live level, folds it into the retired summary (_retiredLevels) and releases its block.
+    void retire_oldest_ordinal_level();
+
+    // Displays the memory used by the ordinal tree: every live level, the arena and the retired summary.
+    void display_ordinal_memory();
+
+    // Loads the configuration from a file into the provided Config object.
+    // Returns true if the configuration is successfully loaded, false otherwise.
+    bool load_config(const string& configFilePath, Config&);
+
+    // Function to map the draw history file and decode it into the draw array (_drawHistory) in a single pass.
+    // Every row is validated as it is decoded: the date must be YYYY-MM-DD, each draw must have the correct
+    // number of entries, and the draw numbers must be within the expected range. Invalid rows are reported and skipped.
+    // Sets _drawHistoryTotal to the number of valid draws. Returns false if the file cannot be opened.
+    bool load_draw_history();
+
+    // Function to decode the rows between 'begin' and 'end' and append the valid draws to the draw array.
+    // 'atFileStart' skips the CSV header line; 'completeLinesOnly' leaves a last line without a newline for later.
+    // Returns the number of bytes consumed.
+    size_t decode_draw_rows(const char *begin, const char *end, bool atFileStart, bool completeLinesOnly);
+
+    // Function to validate and decode one row of the draw history file (without its line ending) into 'draw'.
+    // Returns false, after reporting why, if the row is not a valid draw.
+    bool parse_draw_row(const char *begin, const char *end, DrawRecord& draw);
+
+    // Function to process a single draw vector, updating statistics and events.
+    // Takes a vector of integers (representing a single draw) as input.    
+    void process_draw_vector(DrawSet);
+
+    // Function to process a single decoded draw from the draw array, updating statistics and events.
+    // This is the path the analyzer uses; process_draw_vector forwards to it.
+    void process_draw(const DrawRecord& draw);
+
+    // Processes the next draw of the history and ends the seeding phase once enough draws have been seen.
+    void analyse_draw(const DrawRecord& draw);
+
+    // Keeps the analyzer resident and follows the draw history file until interrupted (SIGINT/SIGTERM).
+    // Appended rows are analysed as they arrive and the refreshed statistics are published; nothing is replayed.
+    // Uses inotify on Linux and polls the file once a second elsewhere.
+    void watch_draw_history();
+
+    // Analyses the draws of the draw array not yet in the statistics (a test run's holdout); returns how many.
+    int analyse_pending_draws();
+
+    // Decodes and analyses the rows appended to the draw history file since it was last read.
+    // Returns the number of newly analysed draws, or -1 when the file is no longer the one read or no longer
+    // starts with the bytes already decoded (it shrank or was replaced) and the history has to be rebuilt.
+    int ingest_appended_draws();
+
+    // Correlates the tree and publishes the statistics after new draws were ingested.
+    void publish_statistics(int newDraws, double seconds);
+
+    // Function to reset flags and other state indicators after processing a draw.
+    // This is typically used to reset the `isDrawn` flags in the draw statistics list.
+    void reset_flags(); 
+
+    // Writes the complete analyzer state (draw statistics, every ordinal level, the seeding flag,
+    // the event counter and the position in the history) to 'path'. Returns false on a write error.
+    bool save_snapshot(const char *path);
+
+    // Restores the analyzer state from a snapshot taken on a prefix of the current draw array.
+    // Returns false, leaving the state untouched, if the file is missing, was written by another build,
+    // was taken past 'drawLimit', or the draws it was taken after no longer match the start of the history.
+    bool restore_snapshot(const char *path, int drawLimit);
+
+    // Fingerprint (FNV-1a) of the dates and numbers of the first 'draws' draws of the draw array.
+    uint64_t history_fingerprint(size_t draws);
+
+    // Writes the draw statistics and every ordinal level in each format of 'formats' (ExportFormat flags),
+    // to files named after 'prefix'. Returns false if any file could not be written.
+    bool export_statistics(const char *prefix, unsigned formats);
+
+    // Writes the draw list and the ordinal levels as two CSV tables, one row per ball or ordinal, in rank order.
+    bool export_statistics_csv(const string& prefix);
+
+    // Writes the draw list and the ordinal levels as JSON lines, one object per ball or ordinal, in rank order.
+    bool export_statistics_jsonl(const string& prefix);
+
+    // Writes the draw list and the ordinal levels in the binary columnar layout (see StatisticsColumnsHeader).
+    bool export_statistics_columns(const string& prefix);
+
+    // Function to collect the remaining draws for testing purposes.
+    // Copies up to _testDrawCount draws from the draw array, starting at the specified draw index, into `_remainingDraws`.
+    void collect_remaining_draws(int startDraw); 
+
+	bool validate_draw_combination(Card);
+	bool prime_number_check(Card);
+
+	// Builds the ball mask of the first 'count' numbers of a card.
+	CardMask card_mask(const int *balls, int count);
+
+	// Validates a card given as the mask of its six main numbers and their sum.
+	// This is the scalar kernel behind validate_draw_combination.
+	bool validate_card_mask(CardMask mainNumbers, int sum);
+
+	// Validates 'count' cards at once, writing 1 (valid) or 0 to 'valid' for each.
+	// Uses AVX-512 or AVX2 lanes when the build targets them and the scalar kernel otherwise.
+	void validate_card_batch(const CardMask *mainNumbers, const int *sums, size_t count, uint8_t *valid);
+
+	// Writes every valid combination to the combination collection file, one card per line.
+	// The combination space is split by its two leading numbers into blocks that are generated
+	// on all cores and written back in order, so the file is identical to a sequential run.
+	void create_all_combinations();
+
+	// Generates and validates every card whose two leading numbers are 'first' and 'second',
+	// appending the valid ones to 'out' as text lines. Returns the number of cards generated.
+	long long generate_combination_block(int first, int second, std::string& out, long long& valid);
+
+	// Builds the binary combination index (see CombinationIndexHeader) and writes it to 'path'.
+	// When 'withRankList' is set, the packed list of valid ranks is stored after the bitset.
+	bool create_combination_index(const char *path, bool withRankList);
+
+	// Attaches the combination index file, building it first when it is missing or out of date.
+	bool load_combination_index();
+
+	// Fills 'weights' (indexed by ball number, slot 0 unused) with the chosen per-ball statistic.
+	void card_score_weights(CardScoreMetric metric, double *weights);
+
+	// Scores every valid combination on all cores and returns the 'count' best and worst cards.
+	// A card's score is the sum or product of 'weights' (indexed by ball number) over its seven numbers.
+	// Validity comes from the combination index when it is attached and from validate_card_mask otherwise.
+	CardScoreReport score_all_combinations(const double *weights, CardScoreCombine combine, int count);
+
+	// Scores every card whose two highest numbers are 'top' and 'second', offering the valid ones to the heaps.
+	// Returns the number of valid cards scored.
+	template <class Combine>
+	long long score_combination_block(int top, int second, const double *weights, Combine combine,
+	                                  BoundedCardHeap<HigherCardScore>& best, BoundedCardHeap<LowerCardScore>& worst);
+
+	// Displays the best and worst cards of a scoring run, with the pair and triple contribution of each.
+	void display_card_scores(const CardScoreReport& report);
+
+	// Gives 'replica', a private instance of one of the parallel engines, the parameters a draw replay depends on:
+	// the sample-size thresholds, the growth policy of the ordinal tree and the recency policy.
+	void copy_replay_parameters(Analyse& replica) const;
+
+	// Copies the analysis state of 'source' (everything init_all resets: the draw table, the co-occurrence counts,
+	// the ordinal tree with its retired levels and recency statistics, and the counters), so the copy can go on
+	// independently of 'source'. The parameters are not copied (see copy_replay_parameters).
+	void copy_analysis_state(const Analyse& source);
+
+	// Walk-forward backtest over 'splits' split points spread across the draw array.
+	// At each split the analyzer is trained on the prefix, the balls are ranked by ordinalChance and by average,
+	// and the next 'horizon' draws are scored (hits in the top 'topN', rank of each drawn ball and log-loss).
+	// One analyzer instance walks the draw array once; the state at each split is copied and scored on the pool.
+	BacktestReport run_backtest(int splits, int horizon, int topN);
+
+	// Scores the draws history[split, split + horizon) against the current (trained) state.
+	BacktestSplit score_backtest_split(const std::vector<DrawRecord>& history, int split, int horizon, int topN);
+
+	// Displays the per-split results and the averages of a backtest next to their chance levels.
+	void display_backtest(const BacktestReport& report);
+
+	// Runs every configuration of 'grid' concurrently on the pool, each in its own analyzer instance.
+	// Each instance is trained on the shared, read-only draw array minus its holdout and scored on the holdout.
+	// Results come back in grid order.
+	std::vector<SweepResult> run_parameter_sweep(const std::vector<SweepParameters>& grid, int topN);
+
+	// Displays the results of a parameter sweep as one table.
+	void display_parameter_sweep(const std::vector<SweepResult>& results, int topN);
+
+	// Monte Carlo null distributions: analyses 'simulations' uniform synthetic histories as long as the
+	// processed real history, through the full pipeline (ingest, tree growth, sorting, correlation), and
+	// places the current per-ball and per-level statistics in the resulting null distributions.
+	// Simulation i always draws from the same stream (derived from 'seed' and i), so the result does not
+	// depend on the thread count. Each worker reuses one analyzer instance, so the runs allocate nothing.
+	NullDistributionReport run_null_simulations(long long simulations, uint64_t seed);
+
+	// Spread of the averages (highest - lowest) of an ordinal level.
+	double ordinal_level_spread(const OrdinalBranchNode& level);
+
+	// Displays where the real statistics fall in their null distributions.
+	void display_null_distribution(const NullDistributionReport& report);
+
+
+    // Flat table that holds statistics for each draw number, indexed by ball.
+    // This table keeps track of various statistics like total times drawn, opportunities, and averages,
+    // along with the rank -> ball permutation that forms the draw list sorted by average.
+    DrawStatisticTable _drawStats;
+
+    // Draw counts of every pair and triple of draw numbers, updated with every draw.
+    CoOccurrenceTable _coOccurrence;
+
+    // The ordinal tree arena: every ordinal level stored back to back in one growable block.
+    // Level 0 references the draw list; each further level references the level before it.
+    std::vector<OrdinalBranchNode> _ordinalTree;
+
+    // The ordinal events and opportunities collected while the current draw is processed.
+    OrdinalDrawBatch _ordinalBatch;
+
+    // Limits on the depth and memory of the ordinal tree, and when its oldest levels retire.
+    OrdinalGrowthPolicy _ordinalGrowth;
+
+    // The retired levels below _ordinalTree[0], summarized.
+    RetiredOrdinalLevels _retiredLevels;
+
+    // Which recency-weighted statistics are kept, and which average ranks the lists.
+    RecencyPolicy _recency;
+
+    // The recency-weighted statistics of the draw table, and of every live level (in step with _ordinalTree).
+    // Both are left empty unless _recency is enabled.
+    RecencyStatistics _drawRecency;
+    std::vector<RecencyStatistics> _ordinalRecency;
+
+
+    // The memory-mapped combination index: which cards are valid, keyed by colex rank.
+    CombinationIndex _combinationIndex;
+
+    // Tracks the total number of draw events that have been processed.
+    // This counter is incremented each time a new draw is processed and is used for various calculations.
+    int _drawHistoryTotal;
+
+    // Number of draws from the draw array that have been processed into the statistics (the position in the history).
+    int _processedDraws = 0;
+
+    // Number of bytes of the draw history file that have been decoded into the draw array.
+    size_t _historyBytesRead = 0;
+
+    // Fingerprint (see fingerprint_history) of those bytes and identity of the file they came from,
+    // to tell an appended file from a replaced one.
+    uint64_t _historyBytesFingerprint = 0;
+    uint64_t _historyFileIdentity = 0;
+
+    // Flag to keep running after the analysis and follow the draw history file for new draws.
+    bool _watchHistory = false;
+
+    // Flag to correlate the ordinal tree after every draw once seeding is complete, so ordinalChance is always current.
+    bool _correlateEveryDraw = false;
+
+    // Threads of pipelined ingest, the ingest thread included (see analyse_draws_pipelined); 0 or 1 processes draws sequentially.
+    int _pipelineThreads = 0;
+
+    // The pipeline draws are handed to while analyse_draws_pipelined runs; null otherwise.
+    OrdinalPipeline *_pipeline = nullptr;
+
+    // Path of the analyzer snapshot; empty when snapshots are disabled.
+    char _snapshotFile[50] = "";
+
+    // Path prefix of the statistics exports, and the formats (ExportFormat flags) written after each analysis; 0 disables them.
+    char _exportPrefix[50] = "";
+    unsigned _exportFormats = 0;
+
+    // Tracks the total number of valid combination cards that have been processed.
+    // This variable is incremented as valid combinations are identified and added to the list.
+    int _totalValidCombinationCards;
+
+    // Tracks the total number of ordinal levels in the ordinal tree.
+    // This counter helps in managing and navigating the structure of ordinal levels.
+    int _ordinalBranchTotalNodes;
+
+   
+
+    // Holds the file path for the draw history file, which contains past draw events.
+    // This file is used to load historical draw data for analysis.
+    char _drawHistoryFile[50];
+
+    // Holds the file path for the combination collection file, which contains combinations to be analyzed.
+    // This file is used to load a collection of combinations for validation and further analysis.
+    char _combinationCollectionFile[50];
+
+    // Holds the file path for the binary combination index.
+    char _combinationIndexFile[50];
+
+    // Flag to store the packed list of valid ranks when the combination index is built.
+    bool _combinationRankList = false;
+
+    // Boolean flag to enable or disable debug mode.
+    // When set to true, this instance logs its debug and trace records (subject to the logger's level).
+    // Analyzer instances created by the parallel engines leave it off.
+    bool _debugMode = false;
+
+    // Flag indicating whether the application is in test mode.
+    // If true, only a subset of draws will be processed, leaving the rest for testing.
+    bool _loadTest = false; 
+
+    // Flag indicating whether the initial seed of draw events has been completed.
+    // This is used to determine when to start calculating ordinal events.
+    bool _seeded = false; 
+
+    // Counter to track the total number of draw events processed.
+    // This includes all draws analyzed during the execution of the program.
+    int _totalEvents; 
+
+    // Every valid draw of the draw history file, in file order, decoded by load_draw_history.
+    std::vector<DrawRecord> _drawHistory;
+
+    // The draws reserved for testing, taken from the end of the draw array.
+    std::vector<DrawRecord> _remainingDraws; 
+
+    // A matrix (vector of vectors) storing the most recent draws processed.
+    // Used to track and analyze the latest draw events.
+    DrawMatrix _lastDraw; 
+
+    // The number of draws to reserve for testing purposes.
+    // This value can be adjusted based on the needs of the test scenario.
+    int _testDrawCount = 100; 
+
+    // A certain amount of draws that produce a somewhat stable (numbers don't move around wild) list.
+    // The ordinal tree starts once this many draws have been processed.
+    int _drawSampleSize = 500;
+
+    // Same as above but for the ordinal lists: a new level is added once the last one has recorded this many events.
+    int _ordinalSampleSize = 500;
+
+    // Number of worker threads used by the parallel engines; 0 means one per core.
+    int _workerThreads = 0;
+
+    // Stream the report is written to: the displays and every message of the instance (loader, snapshots, exports).
+    // The batch driver gives every instance its own buffer, so concurrent analyses do not interleave their reports.
+    std::ostream *_report = &std::cerr;
+
+};
+
+
+Logger _log;
+
+LogRing::LogRing(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    _slots.reset(new Slot[size]);
+    for (size_t i = 0; i < size; i++)
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    _mask = size - 1;
+    _enqueue.store(0, std::memory_order_relaxed);
+    _dequeue.store(0, std::memory_order_relaxed);
+}
+
+bool LogRing::push(const LogRecord& record) {
+    size_t position = _enqueue.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = _slots[position & _mask];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            // The slot is free for this position; claim it.
+            if (_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.record = record;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;   // The consumer has not freed this slot yet: full.
+        } else {
+            position = _enqueue.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool LogRing::pop(LogRecord& record) {
+    size_t position = _dequeue.load(std::memory_order_relaxed);
+    Slot& slot = _slots[position & _mask];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+        return false;   // Empty, or the producer of this slot has not finished writing it.
+    record = slot.record;
+    slot.sequence.store(position + _mask + 1, std::memory_order_release);
+    _dequeue.store(position + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Logger::Logger() : _ring(1 << 16), _level(static_cast<int>(LogLevel::Info)), _started(false), _stopping(false), _dropped(0) {}
+
+void Logger::start() {
+    std::lock_guard<std::mutex> guard(_startLock);
+    if (_started.load(std::memory_order_relaxed) || _stopping.load(std::memory_order_relaxed)) return;
+    _drainer = std::thread(&Logger::drain_loop, this);
+    _started.store(true, std::memory_order_release);
+}
+
+void Logger::stop() {
+    {
+        std::lock_guard<std::mutex> guard(_startLock);
+        _stopping.store(true, std::memory_order_release);
+    }
+    if (_drainer.joinable())
+        _drainer.join();
+    std::string text;
+    while (drain(text) > 0) {}  // Records queued after the drain thread left, if any.
+}
+
+size_t Logger::drain(std::string& text) {
+// Formats up to one batch of queued records into 'text' and writes them in a single call.
+    static const char *levelNames[] = {"[Trace] ", "[Debug] ", "[Info] ", "[Warning] ", "[Error] "};
+    const size_t batch = 4096;
+    size_t records = 0;
+    LogRecord record;
+    text.clear();
+    while (records < batch && _ring.pop(record)) {
+        text += levelNames[static_cast<int>(record.level)];
+        int argument = 0;
+        for (const char *c = record.format; *c; c++) {
+            if (c[0] == '{' && c[1] == '}' && argument < record.argumentCount) {
+                char digits[24];
+                auto converted = std::to_chars(digits, digits + sizeof(digits), record.arguments[argument++]);
+                text.append(digits, converted.ptr);
+                c++;
+            } else {
+                text += *c;
+            }
+        }
+        text += '\n';
+        records++;
+    }
+    unsigned long long dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped)
+        text += "[Warning] " + std::to_string(dropped) + " log records dropped (ring full).\n";
+    if (!text.empty()) {
+        fwrite(text.data(), 1, text.size(), stderr);
+        fflush(stderr);
+    }
+    return records;
+}
+
+void Logger::drain_loop() {
+    std::string text;
+    while (!_stopping.load(std::memory_order_acquire)) {
+        if (drain(text) == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    while (drain(text) > 0) {}
+}
+
+ThreadPool::ThreadPool(unsigned threads) {
+// Function to start the worker threads of the pool.
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; i++)
+        _workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool() {
+// Function to finish the queued jobs and join every worker.
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stopping = true;
+    }
+    _jobReady.notify_all();
+    for (std::thread& worker : _workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _jobs.push_back(std::move(job));
+    }
+    _jobReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(_lock);
+    _allDone.wait(guard, [this]() { return _jobs.empty() && _running == 0; });
+}
+
+void ThreadPool::worker_loop() {
+// Function run by every worker: take the next job off the queue until the pool stops.
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _jobReady.wait(guard, [this]() { return _stopping || !_jobs.empty(); });
+            if (_jobs.empty()) return; // Stopping and nothing left to run.
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            _running++;
+        }
+        job();
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _running--;
+            if (_jobs.empty() && _running == 0)
+                _allDone.notify_all();
+        }
+    }
+}
+
+SpscQueue::SpscQueue(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    _slots.reset(new int[size]);
+    _mask = size - 1;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+}
+
+void SpscQueue::push(int value) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    while (tail - _head.load(std::memory_order_acquire) > _mask)
+        std::this_thread::yield();
+    _slots[tail & _mask] = value;
+    _tail.store(tail + 1, std::memory_order_release);
+}
+
+int SpscQueue::pop() {
+    size_t head = _head.load(std::memory_order_relaxed);
+    while (_tail.load(std::memory_order_acquire) == head)
+        std::this_thread::yield();
+    int value = _slots[head & _mask];
+    _head.store(head + 1, std::memory_order_release);
+    return value;
+}
+
+bool MappedFile::open(const char *path) {
+// Function to map a whole file read-only (or read it into memory where mapping is unavailable).
+    close();
+#if defined(__unix__) || defined(__APPLE__)
+    int descriptor = ::open(path, O_RDONLY);
+    if (descriptor < 0) return false;
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        ::close(descriptor);
+        return false;
+    }
+    _size = static_cast<size_t>(info.st_size);
+    _identity = static_cast<uint64_t>(info.st_dev) * 1099511628211ULL ^ static_cast<uint64_t>(info.st_ino);
+    if (_size == 0) {
+        // Nothing to map; expose an empty, non-null view.
+        ::close(descriptor);
+        _buffer.assign(1, '\0');
+        _data = _buffer.data();
+        return true;
+    }
+    void *view = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (view == MAP_FAILED) {
+        _size = 0;
+        return false;
+    }
+    _data = static_cast<const char *>(view);
+    _mapped = true;
+    return true;
+#else
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    _buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    _size = _buffer.size();
+    _buffer.push_back('\0');
+    _data = _buffer.data();
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (_mapped)
+        munmap(const_cast<char *>(_data), _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+    _identity = 0;
+    _mapped = false;
+    _buffer.clear();
+}
+
+bool BufferedFile::open(const char *path) {
+    close();
+    _file = fopen(path, "wb");
+    _failed = (_file == nullptr);
+    _buffer.reserve(1 << 21);
+    return _file != nullptr;
+}
+
+void BufferedFile::flush() {
+    if (_file && !_buffer.empty() && fwrite(_buffer.data(), 1, _buffer.size(), _file) != _buffer.size())
+        _failed = true;
+    _buffer.clear();
+}
+
+bool BufferedFile::close() {
+    if (!_file) return !_failed;
+    flush();
+    if (fclose(_file) != 0)
+        _failed = true;
+    _file = nullptr;
+    return !_failed;
+}
+
+void RecencyStatistics::reset(const RecencyPolicy& policy) {
+    window = policy.window;
+    decay = policy.decay;
+    memset(&columns, 0, sizeof(columns));
+    ring.assign(static_cast<size_t>(window) * 2 * _drawRange, 0);
+}
+
+void RecencyStatistics::record_histogram(const int *landed, const int *opportunities) {
+    for (int slot = 0; slot < _drawRange; slot++) {
+        columns.pendingLanded[slot] += static_cast<uint8_t>(landed[slot]);
+        columns.pendingOpportunities[slot] += static_cast<uint8_t>(opportunities[slot]);
+    }
+}
+
+void RecencyStatistics::close_draw() {
+    RecencyColumns& c = columns;
+    if (window > 0) {
+        uint8_t *entry = ring.data() + static_cast<size_t>(c.next) * 2 * _drawRange;
+
+        // The oldest draw in a full window leaves it as the new one enters.
+        if (c.filled == window) {
+            for (int slot = 0; slot < _drawRange; slot++) {
+                c.windowLanded[slot] -= entry[slot];
+                c.windowOpportunities[slot] -= entry[_drawRange + slot];
+            }
+        } else {
+            c.filled++;
+        }
+        memcpy(entry, c.pendingLanded, _drawRange);
+        memcpy(entry + _drawRange, c.pendingOpportunities, _drawRange);
+        for (int slot = 0; slot < _drawRange; slot++) {
+            c.windowLanded[slot] += c.pendingLanded[slot];
+            c.windowOpportunities[slot] += c.pendingOpportunities[slot];
+            c.windowAverage[slot] = c.windowOpportunities[slot]
+                ? static_cast<double>(c.windowLanded[slot]) / static_cast<double>(c.windowOpportunities[slot]) : 0.0;
+        }
+        c.next = (c.next + 1) % window;
+    }
+    if (decay > 0.0) {
+        for (int slot = 0; slot < _drawRange; slot++) {
+            c.decayedLanded[slot] = decay * c.decayedLanded[slot] + c.pendingLanded[slot];
+            c.decayedOpportunities[slot] = decay * c.decayedOpportunities[slot] + c.pendingOpportunities[slot];
+            c.decayedAverage[slot] = c.decayedOpportunities[slot] > 0.0 ? c.decayedLanded[slot] / c.decayedOpportunities[slot] : 0.0;
+        }
+    }
+    memset(c.pendingLanded, 0, sizeof(c.pendingLanded));
+    memset(c.pendingOpportunities, 0, sizeof(c.pendingOpportunities));
+}
+
+#if defined(RA_PROFILE)
+thread_local ProfileThreadCounts _profileThread;
+
+// Counts of every thread that has flushed, and the hardware counter descriptors (-1 when not open).
+static std::mutex _profileLock;
+static ProfileCounts _profileTotals;
+static int _profileCycles = -1;
+static int _profileCacheMisses = -1;
+static std::chrono::steady_clock::time_point _profileStart = std::chrono::steady_clock::now();
+
+void flush_profile(ProfileCounts& counts) {
+    std::lock_guard<std::mutex> guard(_profileLock);
+    for (int i = 0; i < static_cast<int>(ProfilePhase::Count); i++) {
+        _profileTotals.phaseNanos[i] += counts.phaseNanos[i];
+        _profileTotals.phaseCalls[i] += counts.phaseCalls[i];
+    }
+    for (int i = 0; i < static_cast<int>(ProfileCounter::Count); i++)
+        _profileTotals.counters[i] += counts.counters[i];
+    for (int i = 0; i < static_cast<int>(ProfileMemory::Count); i++)
+        _profileTotals.allocatedBytes[i] += counts.allocatedBytes[i];
+    counts = ProfileCounts();
+}
+
+#if defined(__linux__)
+// Opens a user-space hardware counter for this process, inherited by the threads it starts.
+static int open_hardware_counter(uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+void start_profile_hardware() {
+#if defined(__linux__)
+    _profileCycles = open_hardware_counter(PERF_COUNT_HW_CPU_CYCLES);
+    _profileCacheMisses = open_hardware_counter(PERF_COUNT_HW_CACHE_MISSES);
+    if (_profileCycles < 0 || _profileCacheMisses < 0)
+        cerr << "[Warning] Hardware counters unavailable (perf_event_open: " << strerror(errno) << ")." << endl;
+#endif
+}
+
+void report_profile(std::ostream& out) {
+    static const char *phaseNames[] = {"ingest", "draw update", "ordinal batch", "draw sort", "ordinal sort", "correlation", "co-occurrence", "combinations", "scoring"};
+    static const char *counterNames[] = {"list-walk steps", "sort swaps", "ordinal levels created", "ordinal levels retired", "draw events", "draw opportunities", "ordinal events", "ordinal opportunities"};
+    static const char *memoryNames[] = {"draw history", "ordinal tree", "combinations"};
+    static_assert(sizeof(phaseNames) / sizeof(*phaseNames) == static_cast<size_t>(ProfilePhase::Count), "a name for every phase");
+    static_assert(sizeof(counterNames) / sizeof(*counterNames) == static_cast<size_t>(ProfileCounter::Count), "a name for every counter");
+    static_assert(sizeof(memoryNames) / sizeof(*memoryNames) == static_cast<size_t>(ProfileMemory::Count), "a name for every subsystem");
+
+    flush_profile(_profileThread);
+    std::lock_guard<std::mutex> guard(_profileLock);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - _profileStart).count();
+
+    out << "Profile (" << std::fixed << std::setprecision(3) << wall << " s wall clock; phase times are summed over threads):" << endl;
+    out << "  " << std::left << std::setw(24) << "Phase" << std::right << std::setw(14) << "Calls" << std::setw(14) << "Total ms" << std::setw(14) << "Mean us" << endl;
+    for (int i = 0; i < static_cast<int>(ProfilePhase::Count); i++) {
+        uint64_t calls = _profileTotals.phaseCalls[i];
+        double milliseconds = _profileTotals.phaseNanos[i] / 1e6;
+        out << "  " << std::left << std::setw(24) << phaseNames[i] << std::right << std::setw(14) << calls
+            << std::setw(14) << std::setprecision(3) << milliseconds
+            << std::setw(14) << (calls ? milliseconds * 1e3 / calls : 0.0) << endl;
+    }
+    out << "  " << std::left << std::setw(24) << "Counter" << std::right << std::setw(14) << "Value" << endl;
+    for (int i = 0; i < static_cast<int>(ProfileCounter::Count); i++)
+        out << "  " << std::left << std::setw(24) << counterNames[i] << std::right << std::setw(14) << _profileTotals.counters[i] << endl;
+    out << "  " << std::left << std::setw(24) << "Allocated" << std::right << std::setw(14) << "Bytes" << endl;
+    for (int i = 0; i < static_cast<int>(ProfileMemory::Count); i++)
+        out << "  " << std::left << std::setw(24) << memoryNames[i] << std::right << std::setw(14) << _profileTotals.allocatedBytes[i] << endl;
+
+    long long cycles = 0, cacheMisses = 0;
+    bool hardware = false;
+#if defined(__linux__)
+    hardware = _profileCycles >= 0 && _profileCacheMisses >= 0
+        && read(_profileCycles, &cycles, sizeof(cycles)) == sizeof(cycles)
+        && read(_profileCacheMisses, &cacheMisses, sizeof(cacheMisses)) == sizeof(cacheMisses);
+#endif
+    if (hardware)
+        out << "  Hardware: " << cycles << " cycles, " << cacheMisses << " cache misses" << endl;
+    else
+        out << "  Hardware: counters unavailable" << endl;
+    out << std::defaultfloat;
+}
+#endif
+
+CombinationIndex::CombinationIndex() {
+    for (int n = 0; n <= _drawRange; n++)
+        for (int k = 0; k <= _drawCardSize; k++)
+            _binomial[n][k] = static_cast<uint64_t>(binomial(n, k));
+}
+
+bool CombinationIndex::attach(const char *path) {
+// Function to map a combination index file and check that it matches this build.
+    detach();
+    if (!_file.open(path)) return false;
+
+    const CombinationIndexHeader *header = reinterpret_cast<const CombinationIndexHeader *>(_file.data());
+    uint64_t totalCards = _binomial[_drawRange][_drawCardSize];
+    uint64_t bitsetBytes = (totalCards + 63) / 64 * 8;
+    if (_file.size() < sizeof(CombinationIndexHeader)
+        || memcmp(header->magic, "RACOMBIX", 8) != 0
+        || header->formatVersion != 1
+        || header->filterVersion != _combinationFilterVersion
+        || header->drawRange != _drawRange
+        || header->cardSize != _drawCardSize
+        || header->totalCards != totalCards
+        || header->bitsetOffset + bitsetBytes > _file.size()
+        || (header->rankListOffset && header->rankListOffset + header->validCards * 4 > _file.size())) {
+        _file.close();
+        return false;
+    }
+
+    _header = header;
+    _bits = reinterpret_cast<const uint64_t *>(_file.data() + header->bitsetOffset);
+    _ranks = header->rankListOffset ? reinterpret_cast<const uint32_t *>(_file.data() + header->rankListOffset) : nullptr;
+    return true;
+}
+
+void CombinationIndex::detach() {
+    _file.close();
+    _header = nullptr;
+    _bits = nullptr;
+    _ranks = nullptr;
+}
+
+uint64_t CombinationIndex::rank_of(const int *card) const {
+    uint64_t rank = 0;
+    for (int i = 0; i < _drawCardSize; i++)
+        rank += _binomial[card[i] - 1][i + 1];
+    return rank;
+}
+
+void CombinationIndex::card_at(uint64_t rank, int *card) const {
+// Function to unrank a colex rank: take the largest number that fits at each slot, from the top down.
+    int value = _drawRange - 1;
+    for (int i = _drawCardSize - 1; i >= 0; i--) {
+        while (_binomial[value][i + 1] > rank)
+            value--;
+        card[i] = value + 1;
+        rank -= _binomial[value][i + 1];
+        value--;
+    }
+}
+
+void Analyse::init_all() {
+// Function to initialize all necessary data structures and settings for the analysis.
+
+    if (_lastDraw.empty())
+        _lastDraw.push_back(DrawSet(_drawCardSize, 0)); // Initialize a new draw set in _lastDraw if needed
+    std::fill(_lastDraw.back().begin(), _lastDraw.back().end(), 0);
+    _totalEvents = 0;
+    _processedDraws = 0;
+    _seeded = false;
+
+    // Initialize each draw number's statistics; the draw list starts in ball order.
+    for (int ball = 0; ball < _drawRange; ball++) {
+        _drawStats.totalTimesDrawn[ball] = 0;
+        _drawStats.isDrawn[ball] = false;
+        _drawStats.drawOpportunities[ball] = 0;
+        _drawStats.average[ball] = 0.0;
+        _drawStats.lastDrawn[ball] = 0;
+        _drawStats.ordinalChance[ball] = 0.0;
+        _drawStats.ordinalSigma[ball] = 0.0;
+        _drawStats.rankedBall[ball] = ball;
+        _drawStats.ballRank[ball] = ball;
+    }
+    memset(&_coOccurrence, 0, sizeof(_coOccurrence)); // No pairs or triples recorded yet.
+
+    // Initialize other necessary members.
+    _totalValidCombinationCards = 0; // Initialize the count of valid combination cards.
+
+    // Nothing is retired yet: updates reach level 1 at their draw list rank.
+    _retiredLevels.levels = 0;
+    for (int rank = 0; rank < _drawRange; rank++) {
+        _retiredLevels.liveSlot[rank] = rank;
+        _retiredLevels.drawRank[rank] = rank;
+        for (int metric = 0; metric < OrdinalMetricCount; metric++)
+            _retiredLevels.metricSum[metric][rank] = 0.0;
+    }
+
+    // Initialize the ordinal tree with its first ordinal list.
+    // A bounded tree reserves its whole arena up front, so it never holds more than the limit.
+    _ordinalTree.clear();
+    _ordinalRecency.clear();
+    if (size_t limit = ordinal_live_level_limit()) {
+        _ordinalTree.reserve(limit);
+        if (_recency.enabled())
+            _ordinalRecency.reserve(limit);
+    }
+    _drawRecency.reset(RecencyPolicy());
+    if (_recency.enabled())
+        _drawRecency.reset(_recency);
+    add_ordinal_level();
+
+    // Initialize other relevant counters and flags.
+    _drawHistoryTotal = 0;
+}
+
+void Analyse::display_draw_statistics() {
+/* Function to display the draw statistics for each number.
+ This function walks the draw list in rank order (rankedBall) and prints out
+ the relevant information for each draw number.*/
+
+    // Print the header for the statistics display.
+    *_report << "Draw Statistics (sorted by average):" << std::endl;
+
+    // Iterate through the draw list from the top rank down.
+	for (int rank = 0; rank < _drawRange; rank++)
+	{
+		int ball = _drawStats.rankedBall[rank];
+
+        // Output the statistics for the current draw number.
+        *_report << "Draw Number: " << ball + 1                                // The draw number being reported.
+                  << " Total Drawn: " << _drawStats.totalTimesDrawn[ball]      // The total number of times this number has been drawn.
+                  << " Opportunities: " << _drawStats.drawOpportunities[ball]  // The number of opportunities this number had to be drawn.
+                  << " Average: " << _drawStats.average[ball]                  // The average position of this number in all draws.
+				  << " Ordinal Chance: " << _drawStats.ordinalChance[ball]      // The calculated chance of this number being drawn in its ordinal position.
+				  << " Ordinal Sigma: " << _drawStats.ordinalSigma[ball]        // The standard error of that chance.
+                  << " Last Drawn: " << _drawStats.lastDrawn[ball];             // The last draw number in which this number was drawn.
+        if (_recency.window > 0)
+            *_report << " Window Average: " << _drawRecency.columns.windowAverage[ball];   // The average over the last window of draws.
+        if (_recency.decay > 0.0)
+            *_report << " Decayed Average: " << _drawRecency.columns.decayedAverage[ball]; // The exponentially decayed average.
+        *_report << std::endl;
+	}
+}
+
+void Analyse::display_ordinal_lists() {
+// Function to display the ordinal lists for each level in the ordinal tree.
+// This function iterates through the levels of the arena, starting from level 0,
+// and prints out the relevant information for each ordinal list at each level.
+
+    // Iterate through the ordinal levels.
+    for (size_t level = 0; level < _ordinalTree.size(); level++)
+    {
+        const OrdinalBranchNode& currentBranch = _ordinalTree[level];
+
+        // Print the level (starting from 1) and sample size for the current ordinal level.
+        *_report << "Ordinal Level " << _retiredLevels.levels + level + 1 << " sample size: " << currentBranch.sampleSize << " List:" << std::endl;
+
+        // Iterate through the ordinal list of the current level in rank order.
+        for (int rank = 0; rank < _drawRange; rank++) {
+            int ordinal = currentBranch.rankedOrdinal[rank];
+
+            // Output the statistics for the current ordinal.
+            *_report << "  Ordinal: " << ordinal + 1                                  // The ordinal position being reported.
+                    << " Average: " << currentBranch.average[ordinal]                 // The average probability for this ordinal position.
+                    << " Landed Total: " << currentBranch.landedTotal[ordinal]        // The total number of times a number has landed in this ordinal position.
+                    << " Opportunities: " << currentBranch.opportunities[ordinal];    // The number of opportunities this ordinal position had.
+            if (_recency.window > 0)
+                *_report << " Window Average: " << _ordinalRecency[level].columns.windowAverage[ordinal];
+            if (_recency.decay > 0.0)
+                *_report << " Decayed Average: " << _ordinalRecency[level].columns.decayedAverage[ordinal];
+            *_report << std::endl;
+        }
+
+        *_report << std::endl; // Print a newline for readability between levels.
+    }
+    display_ordinal_memory();
+}
+
+void Analyse::sort_draws_average() {
+/* Function to sort the draw list based on the 'average' field, or on the windowed or decayed
+   average when _recency.ranking selects one.
+   A single draw only nudges each average a little, so the list is still almost sorted
+   and is re-ranked incrementally: each ball that fell out of order is moved to its new
+   rank by local insertion, and the ball -> rank index follows along. */
+
+    PROFILE_SCOPE(DrawSort);
+    const double *average = draw_ranking_average();
+    rerank_by_insertion(_drawStats.rankedBall, _drawStats.ballRank, _drawRange,
+                        [average](int ball) { return average[ball]; });
+}
+
+void Analyse::sort_ordinal_average(OrdinalBranchNode& Branch, const double *average) {
+/* Function to sort the ordinal list within a given ordinal level based on the given averages.
+The statistics slots stay where they are; only the rank -> ordinal permutation and its
+inverse are updated, using the same incremental insertion as the draw list. */
+
+    rerank_by_insertion(Branch.rankedOrdinal, Branch.ordinalRank, _drawRange,
+                        [average](int ordinal) { return average[ordinal]; });
+}
+
+const double *Analyse::draw_ranking_average() const {
+    if (_recency.ranking == RankingStatistic::Lifetime || !_recency.keeps(_recency.ranking))
+        return _drawStats.average;
+    return _drawRecency.ranking_average(_recency.ranking);
+}
+
+const double *Analyse::ordinal_ranking_average(size_t level) const {
+    if (_recency.ranking == RankingStatistic::Lifetime || !_recency.keeps(_recency.ranking))
+        return _ordinalTree[level].average;
+    return _ordinalRecency[level].ranking_average(_recency.ranking);
+}
+
+void Analyse::close_recency_draw() {
+    _drawRecency.close_draw();
+    for (RecencyStatistics& level : _ordinalRecency)
+        level.close_draw();
+}
+
+template <class KeyOf>
+void Analyse::rerank_by_insertion(int *ranked, int *rankOf, int size, KeyOf keyOf) {
+/* Function to restore the ascending order of a rank permutation after some keys changed.
+The permutation was sorted before the keys moved, so every entry is at most a few ranks
+away from where it belongs. Walking the ranks once, an entry that is smaller than its
+predecessor is lifted out and slid left until it sits behind a key that is not greater;
+every entry it passes moves one rank down and has its inverse index updated. The work is
+one comparison per rank plus one move per rank an entry actually travels, instead of the
+O(n^2) passes of a bubble sort. Equal keys are never passed, so ties keep their order. */
+
+    for (int rank = 1; rank < size; rank++) {
+        int entry = ranked[rank];
+        double key = keyOf(entry);
+
+        // Already in place: the common case.
+        if (!(key < keyOf(ranked[rank - 1]))) continue;
+
+        // Slide the entry towards the top of the list.
+        int slot = rank;
+        do {
+            ranked[slot] = ranked[slot - 1];
+            rankOf[ranked[slot]] = slot;
+            slot--;
+            PROFILE_COUNT(SortSwaps, 1);
+        } while (slot > 0 && key < keyOf(ranked[slot - 1]));
+
+        ranked[slot] = entry;
+        rankOf[entry] = slot;
+    }
+}
+
+void Analyse::record_ordinal_opportunity(int ordinance){
+/* Function to record an opportunity for a specific ordinal position (rank) on every ordinal level.
+It takes a rank position (ordinance) of the sorted draw list and increments the opportunities
+count for the ordinal that references it, because that position could have been drawn but wasn't.
+The position that ordinal currently holds in its own sorted list becomes the ordinance for the
+next level, so the loop carries the opportunity through every level of the arena in turn.
+
+This function is called from within process_draw_vector().*/
+
+    int levels = static_cast<int>(_ordinalTree.size());
+    OrdinalBranchNode* level = _ordinalTree.data();
+    PROFILE_COUNT(OrdinalOpportunities, 1);
+    ordinance = _retiredLevels.liveSlot[ordinance - 1] + 1; // Across the retired levels in one step.
+
+    for (int depth = 0; depth < levels; depth++, level++)
+    {
+        int ordinal = ordinance - 1;
+
+        // Increment the opportunities count for this ordinal position and update its average:
+        // the ratio of the times this ordinal has landed to the number of opportunities it has had.
+        level->opportunities[ordinal]++;
+        level->average[ordinal] = static_cast<double>(level->landedTotal[ordinal]) 
+                                / static_cast<double>(level->opportunities[ordinal]);
+        if (_recency.enabled())
+            _ordinalRecency[depth].record(ordinal, 0);
+
+        // The position held by this ordinal is what the next level references.
+        ordinance = level->ordinalRank[ordinal] + 1;
+    }
+}
+
+void Analyse::apply_ordinal_batch(){
+/* Function to apply a whole draw's ordinal events and opportunities to the ordinal tree.
+Calling calculate_ordinal_event / record_ordinal_opportunity for every update walks the chain
+of levels once per update (about 320 walks per draw). Within a draw no list is re-sorted, so
+each level maps positions to the next level through a fixed permutation; the draw can therefore
+be carried as two 49-slot histograms (landings and opportunities per ordinal). Each level adds
+the histograms to its columns in one pass, recomputes its averages, and permutes the histograms
+through its ordinalRank index to form the next level's input (see advance_ordinal_stream).*/
+
+    const OrdinalDrawBatch& batch = _ordinalBatch;
+    if (batch.size == 0) return;
+    PROFILE_SCOPE(OrdinalBatch);
+    PROFILE_COUNT(OrdinalEvents, batch.events);
+    PROFILE_COUNT(OrdinalOpportunities, batch.size - batch.events);
+
+    OrdinalLevelStream stream;
+    begin_ordinal_stream(stream, batch, static_cast<int>(_ordinalTree.size()), false);
+    advance_ordinal_stream(stream, batch, std::numeric_limits<int>::max());
+}
+
+void Analyse::begin_ordinal_stream(OrdinalLevelStream& stream, const OrdinalDrawBatch& batch, int levels, bool trackSlots){
+    // The first live level is addressed by draw list rank, mapped across the retired levels.
+    const int *liveSlot = _retiredLevels.liveSlot;
+    stream.depth = 0;
+    stream.levels = levels;
+    stream.events = batch.events;
+    stream.streamStart = 0;
+    stream.finished = false;
+    stream.trackSlots = trackSlots;
+    std::fill(stream.landed, stream.landed + _drawRange, 0);
+    std::fill(stream.opportunities, stream.opportunities + _drawRange, 0);
+    for (int i = 0; i < batch.size; i++) {
+        stream.landed[liveSlot[batch.position[i]]] += batch.landed[i];
+        stream.opportunities[liveSlot[batch.position[i]]]++;
+    }
+    if (trackSlots)
+        std::copy(liveSlot, liveSlot + _drawRange, stream.slot);
+}
+
+void Analyse::advance_ordinal_stream(OrdinalLevelStream& stream, const OrdinalDrawBatch& batch, int endDepth){
+/* Function to carry a draw down the ordinal tree from level stream.depth, stopping before level 'endDepth'
+or after the last level, whichever comes first.
+
+The only order-dependent step is growth: a new level starts receiving updates from the draw
+event that pushes the last level past _ordinalSampleSize. When that happens the updates from
+that event onwards are mapped through the existing levels one by one to seed the new level,
+exactly as the per-update path would have done. This happens once every few dozen draws.*/
+
+    int nextLanded[_drawRange];
+    int nextOpportunities[_drawRange];
+    int nextSlot[_drawRange];
+
+    while (!stream.finished && stream.depth < endDepth)
+    {
+        int depth = stream.depth;
+        OrdinalBranchNode& level = _ordinalTree[depth];
+
+        // Apply the whole draw to this level in one pass.
+        for (int ordinal = 0; ordinal < _drawRange; ordinal++) {
+            level.landedTotal[ordinal] += stream.landed[ordinal];
+            level.opportunities[ordinal] += stream.opportunities[ordinal];
+        }
+        for (int ordinal = 0; ordinal < _drawRange; ordinal++) {
+            if (stream.opportunities[ordinal])
+                level.average[ordinal] = static_cast<double>(level.landedTotal[ordinal]) 
+                                       / static_cast<double>(level.opportunities[ordinal]);
+        }
+        if (_recency.enabled())
+            _ordinalRecency[depth].record_histogram(stream.landed, stream.opportunities);
+        int sampleBefore = level.sampleSize;
+        level.sampleSize += stream.events;
+
+        if (depth + 1 < stream.levels) {
+            // Hand the draw on: ordinal o of this level is referenced as position ordinalRank[o] by the next level.
+            for (int ordinal = 0; ordinal < _drawRange; ordinal++) {
+                nextLanded[level.ordinalRank[ordinal]] = stream.landed[ordinal];
+                nextOpportunities[level.ordinalRank[ordinal]] = stream.opportunities[ordinal];
+            }
+            std::copy(nextLanded, nextLanded + _drawRange, stream.landed);
+            std::copy(nextOpportunities, nextOpportunities + _drawRange, stream.opportunities);
+            if (stream.trackSlots)
+                for (int rank = 0; rank < _drawRange; rank++)
+                    stream.slot[rank] = level.ordinalRank[stream.slot[rank]];
+            stream.depth++;
+            continue;
+        }
+
+        // Last level: stop unless this draw pushes its sample size past the threshold and the tree may grow.
+        if (level.sampleSize <= _ordinalSampleSize || !ordinal_tree_can_grow()) {
+            stream.finished = true;
+            break;
+        }
+
+        // Find the draw event that crosses the threshold; it and every later update reach the new level.
+        int crossing = std::max(1, _ordinalSampleSize + 1 - sampleBefore);
+        int seen = 0;
+        for (int i = stream.streamStart; i < batch.size; i++) {
+            if (batch.landed[i] && ++seen == crossing) {
+                stream.streamStart = i;
+                break;
+            }
+        }
+        stream.events -= crossing - 1;
+
+        // Map those updates through every existing level to the ordinals of the new level.
+        if (stream.trackSlots) {
+            for (int rank = 0; rank < _drawRange; rank++)
+                nextSlot[rank] = level.ordinalRank[stream.slot[rank]];
+            std::copy(nextSlot, nextSlot + _drawRange, stream.slot);
+        }
+        std::fill(stream.landed, stream.landed + _drawRange, 0);
+        std::fill(stream.opportunities, stream.opportunities + _drawRange, 0);
+        for (int i = stream.streamStart; i < batch.size; i++) {
+            int position;
+            if (stream.trackSlots) {
+                position = stream.slot[batch.position[i]];
+            } else {
+                position = _retiredLevels.liveSlot[batch.position[i]];
+                for (int mapped = 0; mapped <= depth; mapped++)
+                    position = _ordinalTree[mapped].ordinalRank[position];
+            }
+            stream.landed[position] += batch.landed[i];
+            stream.opportunities[position]++;
+        }
+
+        add_ordinal_level(); // May grow the arena; 'level' is not used past this point.
+        stream.levels++;
+        stream.depth++;
+    }
+}
+
+void Analyse::analyse_draws_pipelined(int first, int last){
+/* Function to replay draws [first, last) of the draw array with the ordinal tree split between threads.
+A draw reaches level k+1 only through the positions level k hands on, and level k is not touched by
+the draw again once it has handed them on. The levels are therefore split into contiguous groups, one
+per stage thread, and the stages form a pipeline: while stage s applies draw t to its levels, stage
+s + 1 applies draw t - 1 to the next ones. This thread keeps the draw list and feeds the first stage.
+Every level still sees the draws in order, and is closed and sorted after each of them before the next
+one arrives, so the statistics are identical to a sequential replay.
+
+The arena must not move while the stages hold references into it, so it is reserved up front for every
+level the replay can add: a new level needs _ordinalSampleSize more events than the level before it got.*/
+
+    OrdinalPipeline pipeline;
+    size_t levels = _ordinalTree.size();
+    size_t reserved = levels + static_cast<size_t>(last - first) * _drawCardSize / static_cast<size_t>(_ordinalSampleSize) + 2;
+    if (size_t limit = ordinal_live_level_limit())
+        reserved = std::max(levels, std::min(reserved, limit));
+    _ordinalTree.reserve(reserved);
+    if (_recency.enabled())
+        _ordinalRecency.reserve(reserved);
+
+    // Split the levels so each stage has about the same work. An existing level takes every draw; a level
+    // added during the replay takes fewer the later it is added.
+    std::vector<double> weight(reserved);
+    double totalWeight = 0.0;
+    for (size_t level = 0; level < reserved; level++) {
+        weight[level] = level < levels ? 1.0 : 1.0 - static_cast<double>(level - levels) / static_cast<double>(reserved - levels);
+        totalWeight += weight[level];
+    }
+    int stages = std::max(1, std::min(_pipelineThreads - 1, static_cast<int>(reserved)));
+    double cumulative = 0.0;
+    pipeline.firstLevel.push_back(0);
+    for (size_t level = 0; level + 1 < reserved && static_cast<int>(pipeline.firstLevel.size()) < stages; level++) {
+        cumulative += weight[level];
+        if (cumulative >= totalWeight * static_cast<double>(pipeline.firstLevel.size()) / stages)
+            pipeline.firstLevel.push_back(static_cast<int>(level) + 1);
+    }
+    pipeline.stages = static_cast<int>(pipeline.firstLevel.size());
+    pipeline.initialLevels = static_cast<int>(levels);
+
+    // Two draws per stage keep every stage busy; the queues hold every draw and the stop value, so a push never waits.
+    pipeline.draws.resize(static_cast<size_t>(2 * pipeline.stages + 2));
+    for (int stage = 0; stage < pipeline.stages; stage++)
+        pipeline.queues.emplace_back(new SpscQueue(pipeline.draws.size() + 1));
+    pipeline.returned.reset(new SpscQueue(pipeline.draws.size() + 1));
+    LOG_DEBUG("Pipelined ingest of {} draws over {} stages.", last - first, pipeline.stages);
 
-        // Traverse the draw statistics list to update statistics for each draw number
-        while (numberNode != NULL) {
-            if (!numberNode->isDrawn) { // Process only if the number has not already been drawn in this draw
-                if (numberNode->drawNumber == ballNumber) 
+    _pipeline = &pipeline;
+    {
+        ThreadPool pool(static_cast<unsigned>(pipeline.stages));
+        for (int stage = 0; stage < pipeline.stages; stage++)
+            pool.submit([this, &pipeline, stage] { run_ordinal_stage(pipeline, stage); });
+        for (int draw = first; draw < last; draw++)
+            analyse_draw(_drawHistory[draw]);
+        pipeline.queues[0]->push(-1);
+        pool.wait();
+    }
+    _pipeline = nullptr;
+}
+
+void Analyse::submit_pipeline_draw(){
+    OrdinalPipeline& pipeline = *_pipeline;
+    int index = pipeline.unused < static_cast<int>(pipeline.draws.size()) ? pipeline.unused++ : pipeline.returned->pop();
+    OrdinalPipelineDraw& draw = pipeline.draws[index];
+
+    draw.batch = _ordinalBatch;
+    draw.seeded = _seeded;
+    if (_seeded && draw.batch.size > 0) {
+        PROFILE_COUNT(OrdinalEvents, draw.batch.events);
+        PROFILE_COUNT(OrdinalOpportunities, draw.batch.size - draw.batch.events);
+        begin_ordinal_stream(draw.stream, draw.batch, 0, true);
+    } else {
+        draw.stream.depth = 0;
+        draw.stream.levels = 0;
+        draw.stream.finished = true;   // Nothing to apply; the stages only close (and sort) their levels.
+    }
+    pipeline.queues[0]->push(index);
+}
+
+void Analyse::run_ordinal_stage(OrdinalPipeline& pipeline, int stage){
+/* Function to run one stage of pipelined ingest until the stop value (-1) arrives.
+The stage owns the levels [firstLevel, endLevel); nothing else writes to them while the pipeline runs.
+A draw is handed on as soon as it has been applied to the stage's levels, then the stage closes and
+sorts them for that draw while the next stage works on it. A level added by this stage past endLevel
+belongs to the next stage, which learns of it from the draw that added it.*/
+
+    int firstLevel = pipeline.firstLevel[stage];
+    bool lastStage = stage + 1 == pipeline.stages;
+    int endLevel = lastStage ? std::numeric_limits<int>::max() : pipeline.firstLevel[stage + 1];
+    SpscQueue& input = *pipeline.queues[stage];
+    SpscQueue& output = lastStage ? *pipeline.returned : *pipeline.queues[stage + 1];
+    int knownLevels = pipeline.initialLevels;  // Levels in the tree, as far as the draws seen so far tell.
+
+    for (;;) {
+        int index = input.pop();
+        if (index < 0) {
+            if (!lastStage)
+                output.push(index);
+            break;
+        }
+
+        OrdinalPipelineDraw& draw = pipeline.draws[index];
+        bool seeded = draw.seeded;
+        draw.stream.levels = std::max(draw.stream.levels, knownLevels);
+        advance_ordinal_stream(draw.stream, draw.batch, endLevel);
+        knownLevels = draw.stream.levels;
+        output.push(index); // The draw belongs to the next stage from here on.
+
+        int ownEnd = std::min(endLevel, knownLevels);
+        for (int level = firstLevel; level < ownEnd; level++) {
+            if (_recency.enabled())
+                _ordinalRecency[level].close_draw();
+            if (seeded)
+                sort_ordinal_average(_ordinalTree[level], ordinal_ranking_average(level));
+        }
+    }
+}
+
+void Analyse::process_draw_vector(DrawSet draw) {
+    DrawRecord record = {};
+
+    // A draw with more balls than a card holds is malformed and would overrun the draw slots.
+    if (draw.size() != static_cast<size_t>(_drawCardSize)) {
+        *_report << "[Error] Draw has " << draw.size() << " balls, expected " << _drawCardSize << "; skipping." << std::endl;
+        return;
+    }
+    for (int slot = 0; slot < _drawCardSize; slot++)
+        record.balls[slot] = static_cast<uint8_t>(draw[slot]);
+    process_draw(record);
+}
+
+void Analyse::process_draw(const DrawRecord& draw) {
+    PROFILE_SCOPE(DrawUpdate);
+    int drawCardSlot = 0;          // Counter for the position within the current draw.
+
+    _ordinalBatch.size = 0;
+    _ordinalBatch.events = 0;
+    _processedDraws++; // This draw's number in the history.
+
+    // Process each ball number in the draw
+    for (int ballNumber : draw.balls) {
+        _lastDraw.back()[drawCardSlot] = ballNumber; // Store the ball number in the current draw slot of the last draw in _lastDraw
+        if (_debugMode)
+            LOG_TRACE("Ball {} drawn in slot {}", ballNumber, drawCardSlot);
+
+        // Walk the draw list in rank order to update statistics for each draw number.
+        // Location counter starts at 1.
+        PROFILE_COUNT(ListWalkSteps, _drawRange);
+        for (int drawListLocation = 1; drawListLocation <= _drawRange; drawListLocation++) {
+            int ball = _drawStats.rankedBall[drawListLocation - 1];
+            if (!_drawStats.isDrawn[ball]) { // Process only if the number has not already been drawn in this draw
+                bool matched = (ball + 1 == ballNumber);
+                if (matched) 
                 {
                     _totalEvents++; // Increment total draw events counter
-                    calculate_draw_event(numberNode); // Perform draw event calculations for the matched number
-
-                    // If seeding is complete, calculate ordinal events for the matched number
-                    if ( _seeded ) {
-                        calculate_ordinal_event(drawListLocation, _ordinalTreeStart);
-                    }
+                    calculate_draw_event(ball); // Perform draw event calculations for the matched number
+                    PROFILE_COUNT(DrawEvents, 1);
 
                     if (_debugMode)
-                        std::cout << "[Debug] Ball " << ballNumber << " matches DrawNumber at location " << drawListLocation << std::endl;
+                        LOG_TRACE("Ball {} matches DrawNumber at location {}", ballNumber, drawListLocation);
                 } 
 				else 
 				{
-                    numberNode->drawOpportunities++; // Increment opportunities for unmatched numbers
-
-                    // If seeding is complete, record ordinal opportunities for unmatched numbers
-                    if ( _seeded ) {
-                        record_ordinal_opportunity(drawListLocation, _ordinalTreeStart);
-                    }
+                    _drawStats.drawOpportunities[ball]++; // Increment opportunities for unmatched numbers
+                    PROFILE_COUNT(DrawOpportunities, 1);
+                }
+                if (_recency.enabled())
+                    _drawRecency.record(ball, matched);
+
+                // If seeding is complete, collect the ordinal event or opportunity for this location;
+                // the ordinal tree takes the whole draw at once below.
+                if ( _seeded ) {
+                    _ordinalBatch.position[_ordinalBatch.size] = drawListLocation - 1;
+                    _ordinalBatch.landed[_ordinalBatch.size] = matched;
+                    _ordinalBatch.events += matched;
+                    _ordinalBatch.size++;
                 }
             }
-            numberNode = numberNode->_next; // Move to the next draw number in the list
-            drawListLocation++;
         }
         drawCardSlot++; // Move to the next slot in the draw
     }
+    record_co_occurrence(draw);
+
+    // If seeding is complete, apply the draw's ordinal events and opportunities to every level.
+    // Pipelined ingest hands every draw to the stages instead; they apply, close and sort the levels themselves.
+    if ( _pipeline ) {
+        submit_pipeline_draw();
+    } else if ( _seeded ) {
+        apply_ordinal_batch();
+    }
 
     // Reset the isDrawn flag for all draw numbers after processing the current draw
     reset_flags();
 
+    // Move the draw into the windowed and decayed statistics before they rank the lists.
+    if (_recency.enabled()) {
+        if (_pipeline)
+            _drawRecency.close_draw();
+        else
+            close_recency_draw();
+    }
+
     // Sort the draw statistics list based on the updated averages
     sort_draws_average();
 
     // If seeding is complete, sort the ordinal lists for further analysis
-    if ( _seeded ) {
+    if ( _seeded && !_pipeline ) {
         sort_ordinal_lists();
+
+        // Retire the oldest levels that have stabilized; at least one level stays live.
+        while (_ordinalGrowth.retireSampleSize > 0 && _ordinalTree.size() > 1
+               && _ordinalTree.front().sampleSize >= _ordinalGrowth.retireSampleSize)
+            retire_oldest_ordinal_level();
     }
 }
 
 void Analyse::analyse_all_draws(){
-/* Function to analyze all draw events from a historical draw file.
-This function processes each draw in the file, updates the draw statistics,
-records ordinal opportunities, and sorts the draw and ordinal lists as needed.*/
+/* Function to analyze all draw events from the draw history.
+The history file is decoded once into the draw array; this function then processes each draw
+from the array, updating the draw statistics, recording ordinal opportunities, and sorting the
+draw and ordinal lists as needed.*/
 
-    DrawStatisticNode* numberNode; // Pointer to traverse the linked list of draw statistics.
     int totalDraws = 0;            // Counter for the total number of draws processed.
     int drawLimit;                 // Limit for the number of draws to process.
-    string line;                   // String to hold each line read from the file.
-    string drawDate = "";          // Variable to store the date of the draw (currently unused).
-    int drawSlot = 0;              // Counter for the position within the current draw.
 
-    // Open the draw history file and perform initial census validation checks.
-    ifstream file = collect_census();
-    if (!file.is_open()) return; // Exit if the file could not be opened.
+    // Map, validate and decode the draw history file.
+    if (!load_draw_history()) return; // Exit if the file could not be opened.
 
     // Determine the draw limit based on whether the program is in test mode.
-    // If in test mode (_loadTest is true), process all but the last 100 draws for testing purposes.
+    // If in test mode (_loadTest is true), process all but the last _testDrawCount draws for testing purposes.
     // Otherwise, process all available draws.
     if (_loadTest)
-        drawLimit = _drawHistoryTotal - 100; 
+        drawLimit = std::max(0, _drawHistoryTotal - _testDrawCount);
     else
         drawLimit = _drawHistoryTotal;       
 
-    // Skip the header line of the CSV file to start processing the actual draw data.
-    getline(file, line);
+    // Resume from the snapshot, if one was taken on the start of this history.
+    if (_snapshotFile[0] && restore_snapshot(_snapshotFile, drawLimit)) {
+        totalDraws = _processedDraws;
+        *_report << "[Info] Resumed from snapshot at draw " << totalDraws << "." << std::endl;
+    }
+
+    // Replay the history through the pipeline when asked to. Retiring levels and correlating after every
+    // draw both need the whole tree between two draws, so they keep the replay on one thread.
+    if (_pipelineThreads > 1 && totalDraws < drawLimit) {
+        if (_ordinalGrowth.retireSampleSize > 0 || _correlateEveryDraw) {
+            *_report << "[Warning] pipelineThreads is not used with ordinalRetireSampleSize or correlateEveryDraw; replaying on one thread." << endl;
+        } else {
+            analyse_draws_pipelined(totalDraws, drawLimit);
+            totalDraws = drawLimit;
+        }
+    }
 
-    // Read and process each line from the file until the end or the specified limit.
+    // Process each draw from the array until the specified limit.
     while (totalDraws < drawLimit) {
-        getline(file, line);
-        stringstream ss(line);
+        analyse_draw(_drawHistory[totalDraws]);
+        totalDraws++; // Increment the total draws counter.
+    }
+
+    // Save the state so the next run only has to process the draws appended after this one.
+    if (_snapshotFile[0])
+        save_snapshot(_snapshotFile);
 
-        // Extract the draw data into a DrawMatrix (vector of vectors).
-        DrawSet drawData = extract_draw_vector(line);
+    // Collect the remaining draws for testing.
+    collect_remaining_draws(totalDraws);
+    LOG_DEBUG("Finished processing all draws ({} draws).", totalDraws);
+}
 
-        // Process the draw data using the draw vector.
-        process_draw_vector(drawData);
+void Analyse::analyse_draw(const DrawRecord& draw){
+    process_draw(draw);
 
-        totalDraws++; // Increment the total draws counter.
-        // Determine if the draw events should start affecting the ordinal list calculations.
-        if (!_seeded) {
-            if (totalDraws > _drawSampleSize)
-                _seeded = true;
+    // Determine if the draw events should start affecting the ordinal list calculations.
+    if (!_seeded) {
+        if (_processedDraws > _drawSampleSize)
+            _seeded = true;
+    }
+
+    // Keep the correlated statistics current for live reporting.
+    if (_correlateEveryDraw && _seeded)
+        correlate_data();
+}
+
+// Set by SIGINT/SIGTERM to stop watch_draw_history.
+static volatile sig_atomic_t _stopWatching = 0;
+
+static void stop_watching(int) {
+    _stopWatching = 1;
+}
+
+// Continues an FNV-1a hash ('hash') over 'size' bytes; start from 14695981039346656037.
+static uint64_t fingerprint_bytes(uint64_t hash, const char *bytes, size_t size) {
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ static_cast<unsigned char>(bytes[i])) * 1099511628211ULL;
+    return hash;
+}
+
+// Bytes at each end of the decoded part of the history file that are fingerprinted.
+constexpr size_t _historyFingerprintWindow = 4096;
+
+static uint64_t fingerprint_history(const char *bytes, size_t size) {
+// Fingerprints the first and last _historyFingerprintWindow bytes of the 'size' decoded bytes (all of them when
+// fewer), so checking an update costs the same however long the history grows.
+    size_t head = std::min(size, _historyFingerprintWindow);
+    uint64_t hash = fingerprint_bytes(14695981039346656037ULL, bytes, head);
+    size_t tail = std::min(size - head, _historyFingerprintWindow);
+    return fingerprint_bytes(hash, bytes + size - tail, tail);
+}
+
+int Analyse::analyse_pending_draws(){
+// Function to analyse the draws of the draw array that are not in the statistics yet; returns how many.
+    int pending = 0;
+    for (; _processedDraws < static_cast<int>(_drawHistory.size()); pending++)
+        analyse_draw(_drawHistory[_processedDraws]);
+    return pending;
+}
+
+int Analyse::ingest_appended_draws(){
+    MappedFile file;
+    if (!file.open(_drawHistoryFile)) return 0; // Being replaced; try again on the next change.
+    // The file must be the same file and still hold the bytes already decoded; otherwise it was truncated
+    // or replaced.
+    if (file.identity() != _historyFileIdentity || file.size() < _historyBytesRead
+        || fingerprint_history(file.data(), _historyBytesRead) != _historyBytesFingerprint)
+        return -1;
+
+    size_t consumed = decode_draw_rows(file.data() + _historyBytesRead, file.data() + file.size(),
+                                       _historyBytesRead == 0, true);
+    _historyBytesRead += consumed;
+    _historyBytesFingerprint = fingerprint_history(file.data(), _historyBytesRead);
+    _drawHistoryTotal = static_cast<int>(_drawHistory.size());
+
+    // The holdout is not kept back while following the file: every new draw is analysed.
+    return analyse_pending_draws();
+}
+
+void Analyse::publish_statistics(int newDraws, double seconds){
+    const DrawRecord& latest = _drawHistory.back();
+    *_report << "[Info] Ingested " << newDraws << " new draw(s) up to draw " << _processedDraws
+         << " (" << latest.date / 10000 << '-' << setw(2) << setfill('0') << latest.date / 100 % 100
+         << '-' << setw(2) << latest.date % 100 << setfill(' ') << ") in "
+         << static_cast<long long>(seconds * 1e6) << " us" << endl;
+    display_draw_statistics();
+    if (_exportFormats)
+        export_statistics(_exportPrefix, _exportFormats);
+    if (_snapshotFile[0])
+        save_snapshot(_snapshotFile);
+}
+
+void Analyse::watch_draw_history(){
+/* Function to keep the analyzer resident and follow the draw history file.
+The analyzer state stays in memory, so a change to the file only costs decoding the appended rows,
+processing them as draws and re-correlating the tree. If the file shrinks or is replaced (it is another
+file, or the ends of the bytes already decoded no longer match their fingerprint), the history is
+rebuilt from scratch.*/
+
+    signal(SIGINT, stop_watching);
+    signal(SIGTERM, stop_watching);
+    *_report << "[Info] Watching " << _drawHistoryFile << " for new draws (Ctrl+C to stop)." << endl;
+
+    // A test run held the last draws back; they are analysed before following the file, so the statistics
+    // (and any snapshot saved of them) cover every decoded draw.
+    auto catchUp = std::chrono::steady_clock::now();
+    if (int heldBack = analyse_pending_draws()) {
+        correlate_data();
+        publish_statistics(heldBack, std::chrono::duration<double>(std::chrono::steady_clock::now() - catchUp).count());
+    }
+
+#if defined(__linux__)
+    const uint32_t watchEvents = IN_MODIFY | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF;
+    int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    int watch = notify >= 0 ? inotify_add_watch(notify, _drawHistoryFile, watchEvents) : -1;
+    if (watch < 0)
+        *_report << "[Warning] inotify unavailable, polling the draw history file instead." << endl;
+#endif
+
+    while (!_stopWatching) {
+        bool changed = false;
+#if defined(__linux__)
+        if (watch >= 0) {
+            pollfd waiting = {notify, POLLIN, 0};
+            if (poll(&waiting, 1, 500) <= 0) continue;
+
+            // Drain the queued events; a moved or deleted file is watched again under its path.
+            bool replaced = false;
+            alignas(inotify_event) char events[4096];
+            ssize_t length;
+            while ((length = read(notify, events, sizeof(events))) > 0) {
+                for (char *event = events; event < events + length; ) {
+                    const inotify_event *notice = reinterpret_cast<const inotify_event *>(event);
+                    replaced |= (notice->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)) != 0;
+                    event += sizeof(inotify_event) + notice->len;
+                }
+            }
+            if (replaced) {
+                inotify_rm_watch(notify, watch);
+                while (!_stopWatching && (watch = inotify_add_watch(notify, _drawHistoryFile, watchEvents)) < 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            }
+            changed = true;
+        } else
+#endif
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            changed = true;
+        }
+        if (!changed || _stopWatching) continue;
+
+        auto start = std::chrono::steady_clock::now();
+        int newDraws = ingest_appended_draws();
+        if (newDraws < 0) {
+            *_report << "[Warning] Draw history file shrank or was replaced; rebuilding the analysis." << endl;
+            init_all();
+            analyse_all_draws();
+            analyse_pending_draws();
+            newDraws = _processedDraws;
         }
+        if (newDraws == 0) continue;
+        correlate_data();
+        publish_statistics(newDraws, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
     }
 
-    // Collect the remaining draws for testing.
-    collect_remaining_draws(file, totalDraws);
+#if defined(__linux__)
+    if (notify >= 0) ::close(notify);
+#endif
+    *_report << "[Info] Stopped watching the draw history file." << endl;
+}
+
+static void ordinal_level_metrics(const OrdinalBranchNode& branch, double metrics[OrdinalMetricCount][_drawRange]) {
+// Fills the value every OrdinalMetric takes for each ordinal (slot) of a level.
+    for (int ordinal = 0; ordinal < _drawRange; ordinal++)
+        metrics[MetricAverage][ordinal] = branch.average[ordinal];
+    for (int ordinal = 0; ordinal < _drawRange; ordinal++) {
+        double average = branch.average[ordinal];
+        int opportunities = branch.opportunities[ordinal];
+        metrics[MetricVariance][ordinal] = opportunities > 0 ? average * (1.0 - average) / opportunities : 0.0;
+    }
+}
 
-    // Close the file after processing all draws.
-    file.close();
-    std::cout << "[Debug] Finished processing all draws." << std::endl;
+void Analyse::correlate_data(){
+/* Function to correlate data across the ordinal branches, starting from the last branch and moving backward.
+Every ordinal of the last level starts a chain: it references a position one level down, the ordinal at that
+position references a position further down, and so on to the draw list. Each metric (OrdinalMetric) is
+summed along the chain, and the sums reaching each ordinal become its ordinalChance.
+Because the sorted order of every level is a permutation array, all 49 chains move down together, one pass
+per level: 'carried' holds the sums that reach each position of the current level, a gather through
+ordinalRank gives each ordinal the sums reaching the position it holds, and adding the ordinal's own metrics
+gives the sums that reach the position it references. The passes are plain loops over fixed-size columns,
+so the cost is a few hundred operations per level and correlate_data can run after every draw.*/
+
+    PROFILE_SCOPE(Correlation);
+
+    // Start at the last level in the arena: ordinal o sits at the top of its chain and references position o below.
+    int lastLevel = static_cast<int>(_ordinalTree.size()) - 1;
+    double carried[OrdinalMetricCount][_drawRange];
+    ordinal_level_metrics(_ordinalTree[lastLevel], carried);
+
+    // Walk down through the levels below it, one pass per level.
+    for (int depth = lastLevel - 1; depth >= 0; depth--)
+    {
+        OrdinalBranchNode& branchNode = _ordinalTree[depth];
+        double reaching[OrdinalMetricCount][_drawRange];
+        double own[OrdinalMetricCount][_drawRange];
+
+        // Gather: the sums reaching an ordinal are the ones carried to the position (rank) it holds.
+        for (int metric = 0; metric < OrdinalMetricCount; metric++)
+            for (int ordinal = 0; ordinal < _drawRange; ordinal++)
+                reaching[metric][ordinal] = carried[metric][branchNode.ordinalRank[ordinal]];
+        std::copy(reaching[MetricAverage], reaching[MetricAverage] + _drawRange, branchNode.ordinalChance);
+
+        // Add: the ordinal's own metrics carry the sums on to the position it references one level down.
+        ordinal_level_metrics(branchNode, own);
+        for (int metric = 0; metric < OrdinalMetricCount; metric++)
+            for (int ordinal = 0; ordinal < _drawRange; ordinal++)
+                carried[metric][ordinal] = own[metric][ordinal] + reaching[metric][ordinal];
+    }
+
+    // Cross the retired levels, if any: their metrics along the way are one precomputed sum per position.
+    // Then the draw list: the final sums go to the draw number at each position.
+    for (int position = 0; position < _drawRange; position++)
+    {
+        int ball = _drawStats.rankedBall[_retiredLevels.drawRank[position]];
+        _drawStats.ordinalChance[ball] = carried[MetricAverage][position] + _retiredLevels.metricSum[MetricAverage][position];
+        _drawStats.ordinalSigma[ball] = std::sqrt(carried[MetricVariance][position] + _retiredLevels.metricSum[MetricVariance][position]);
+    }
+/* end of function
+Explanation of the Function:
+1. The sums start at the last level with that level's own metrics; its ordinalChance is not set, as nothing references it.
+2. For every level below, the sums reaching each ordinal are gathered through the level's ordinalRank and its
+   ordinalChance is set from the average sums.
+3. The level's own metrics are then added, giving the sums that reach each position of the level below it.
+4. After level 0 the retired levels are crossed with one addition, and the sums are handed to the draw numbers:
+   the average sum is the draw number's ordinalChance and the root of the variance sum is its ordinalSigma.
+5. The sums are added in the same order the chains are followed, so the results do not depend on how the
+   chains are walked.*/
+}
+
+uint64_t Analyse::history_fingerprint(size_t draws) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint32_t value) {
+        hash = (hash ^ value) * 1099511628211ULL;
+    };
+    for (size_t i = 0; i < draws && i < _drawHistory.size(); i++) {
+        mix(_drawHistory[i].date);
+        for (uint8_t ball : _drawHistory[i].balls)
+            mix(ball);
+    }
+    return hash;
+}
+
+bool Analyse::save_snapshot(const char *path) {
+/* Function to write the complete analyzer state to a snapshot file.
+The draw table and the ordinal tree arena are flat blocks, so the snapshot is the header followed by
+straight copies of them. The file is written next to the target and renamed over it, so a crash while
+saving never leaves a damaged snapshot behind.*/
+
+    AnalyseSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "RASNAPST", 8);
+    header.formatVersion = _snapshotFormatVersion;
+    header.drawRange = _drawRange;
+    header.cardSize = _drawCardSize;
+    header.drawSampleSize = _drawSampleSize;
+    header.ordinalSampleSize = _ordinalSampleSize;
+    header.drawTableBytes = sizeof(DrawStatisticTable);
+    header.coOccurrenceBytes = sizeof(CoOccurrenceTable);
+    header.levelBytes = sizeof(OrdinalBranchNode);
+    header.levels = static_cast<uint32_t>(_ordinalTree.size());
+    header.retiredBytes = sizeof(RetiredOrdinalLevels);
+    header.maxLevels = static_cast<uint32_t>(_ordinalGrowth.maxLevels);
+    header.retireSampleSize = static_cast<uint32_t>(_ordinalGrowth.retireSampleSize);
+    header.memoryBudget = _ordinalGrowth.memoryBudget;
+    header.recencyWindow = static_cast<uint32_t>(_recency.window);
+    header.ranking = static_cast<uint32_t>(_recency.ranking);
+    header.recencyDecay = _recency.decay;
+    header.seeded = _seeded;
+    header.totalEvents = _totalEvents;
+    header.processedDraws = static_cast<uint64_t>(_processedDraws);
+    header.historyFingerprint = history_fingerprint(_processedDraws);
+    for (int slot = 0; slot < _drawCardSize; slot++)
+        header.lastDraw[slot] = _lastDraw.back()[slot];
+
+    string temporaryPath = string(path) + ".tmp";
+    FILE *snapshotFile = fopen(temporaryPath.c_str(), "wb");
+    if (!snapshotFile) {
+        *_report << "[Error] Failed to open snapshot for writing: " << temporaryPath << endl;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, snapshotFile) == 1
+                && fwrite(&_drawStats, sizeof(DrawStatisticTable), 1, snapshotFile) == 1
+                && fwrite(&_coOccurrence, sizeof(CoOccurrenceTable), 1, snapshotFile) == 1
+                && fwrite(&_retiredLevels, sizeof(RetiredOrdinalLevels), 1, snapshotFile) == 1
+                && fwrite(_ordinalTree.data(), sizeof(OrdinalBranchNode), _ordinalTree.size(), snapshotFile) == _ordinalTree.size();
+    auto writeRecency = [snapshotFile](const RecencyStatistics& recency) {
+        return fwrite(&recency.columns, sizeof(RecencyColumns), 1, snapshotFile) == 1
+            && fwrite(recency.ring.data(), 1, recency.ring.size(), snapshotFile) == recency.ring.size();
+    };
+    if (_recency.enabled()) {
+        written = written && writeRecency(_drawRecency);
+        for (const RecencyStatistics& level : _ordinalRecency)
+            written = written && writeRecency(level);
+    }
+    if (fclose(snapshotFile) != 0 || !written || rename(temporaryPath.c_str(), path) != 0) {
+        *_report << "[Error] Failed to write snapshot: " << path << endl;
+        remove(temporaryPath.c_str());
+        return false;
+    }
+    if (_debugMode)
+        *_report << "Snapshot written at draw " << _processedDraws << " (" << _ordinalTree.size() << " ordinal levels): " << path << endl;
+    return true;
 }
 
-void Analyse::correlate_data(){
-/* Function to correlate data across the ordinal branches, starting from the last branch and moving backward.
-This function propagates statistical calculations (currently the average) from the last ordinal branch
-back through the previous branches. Future expansions will likely include other statistical metrics
-such as sigma, standard deviation, and others, requiring updates to the data structures.*/
+bool Analyse::export_statistics(const char *prefix, unsigned formats) {
+/* Function to export the statistics in every requested format.
+Each format is one pass over the draw table and the ordinal tree arena into a buffered file.*/
+
+    string base = prefix;
+    bool exported = true;
+    auto start = std::chrono::steady_clock::now();
+    if (formats & ExportCsv) exported = export_statistics_csv(base) && exported;
+    if (formats & ExportJsonLines) exported = export_statistics_jsonl(base) && exported;
+    if (formats & ExportColumns) exported = export_statistics_columns(base) && exported;
+    if (_debugMode)
+        *_report << "[Info] Exported " << _ordinalTree.size() << " ordinal levels to " << base << ".* in "
+             << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << endl;
+    return exported;
+}
 
-    OrdinalBranchNode* currentBranch;        // Pointer to traverse the ordinal branches.
-    OrdinalStatisticNode* currentListNode;    // Pointer to traverse the ordinal list nodes within a branch.
-    currentBranch = _ordinalTreeStart;
+bool Analyse::export_statistics_csv(const string& prefix) {
+    BufferedFile draws, ordinals;
+    string drawPath = prefix + ".draws.csv", ordinalPath = prefix + ".ordinals.csv";
+    if (!draws.open(drawPath.c_str()) || !ordinals.open(ordinalPath.c_str())) {
+        *_report << "[Error] Failed to open export file for writing: " << prefix << ".*.csv" << endl;
+        return false;
+    }
 
-    // Traverse to the last ordinal branch in the linked list.
-    while (currentBranch->_next != nullptr){
-        currentBranch = currentBranch->_next;
+    draws.text("rank,ball,total_drawn,opportunities,average,ordinal_chance,ordinal_sigma,last_drawn");
+    draws.end_row();
+    for (int rank = 0; rank < _drawRange; rank++) {
+        int ball = _drawStats.rankedBall[rank];
+        draws.number(rank + 1);                          draws.character(',');
+        draws.number(ball + 1);                          draws.character(',');
+        draws.number(_drawStats.totalTimesDrawn[ball]);  draws.character(',');
+        draws.number(_drawStats.drawOpportunities[ball]); draws.character(',');
+        draws.number(_drawStats.average[ball]);          draws.character(',');
+        draws.number(_drawStats.ordinalChance[ball]);    draws.character(',');
+        draws.number(_drawStats.ordinalSigma[ball]);     draws.character(',');
+        draws.number(_drawStats.lastDrawn[ball]);
+        draws.end_row();
     }
 
-    // Start at the last branch's list and iterate through its ordinal list nodes.
-    currentListNode = currentBranch->listNode;
-    while (currentListNode != nullptr)
-    {
-        // Propagate the average from the current list node to the previous branches.
-        // Currently, this only handles the average, but future versions will need to handle
-        // other statistical calculations (e.g., sigma, standard deviation).
-        propagate_statistical_tree(currentListNode->ordinal, currentListNode->average, currentBranch->_previous);
+    ordinals.text("level,rank,ordinal,sample_size,landed_total,opportunities,average,ordinal_chance");
+    ordinals.end_row();
+    for (size_t level = 0; level < _ordinalTree.size(); level++) {
+        const OrdinalBranchNode& branch = _ordinalTree[level];
+        for (int rank = 0; rank < _drawRange; rank++) {
+            int ordinal = branch.rankedOrdinal[rank];
+            ordinals.number(_retiredLevels.levels + level + 1); ordinals.character(',');
+            ordinals.number(rank + 1);                        ordinals.character(',');
+            ordinals.number(ordinal + 1);                     ordinals.character(',');
+            ordinals.number(branch.sampleSize);               ordinals.character(',');
+            ordinals.number(branch.landedTotal[ordinal]);     ordinals.character(',');
+            ordinals.number(branch.opportunities[ordinal]);   ordinals.character(',');
+            ordinals.number(branch.average[ordinal]);         ordinals.character(',');
+            ordinals.number(branch.ordinalChance[ordinal]);
+            ordinals.end_row();
+        }
+    }
 
-        // Move to the next node in the ordinal list.
-        currentListNode = currentListNode->_next;
+    if (!draws.close() || !ordinals.close()) {
+        *_report << "[Error] Failed to write export files: " << prefix << ".*.csv" << endl;
+        return false;
     }
+    return true;
 }
 
-void Analyse::propagate_statistical_tree(int ordinance, double ordinalSum, OrdinalBranchNode*& branchNode){
-/* Function to propagate statistical calculations (currently ordinal sum) through the ordinal branches.
-This function works recursively, starting from a given branch node and moving backward through the linked list
-of branches until it reaches the base branch node, which references the draw list sorted by averages.
-At each level, the function updates the ordinal chance with the cumulative sum of averages.*/
-
-    OrdinalStatisticNode* currentListNode;  // Pointer to traverse the ordinal list nodes within the current branch.
-    currentListNode = branchNode->listNode;  // Start with the head of the ordinal list in the given branch.
-
-    int listOrdinance = 1;  // Counter to track the position within the ordinal list.
-    
-    // Traverse to the ordinal list node that corresponds to the given ordinance.
-    while (listOrdinance < ordinance){
-        currentListNode = currentListNode->_next;  // Move to the next node.
-        listOrdinance++;  // Increment the position counter.
+bool Analyse::export_statistics_jsonl(const string& prefix) {
+    BufferedFile draws, ordinals;
+    string drawPath = prefix + ".draws.jsonl", ordinalPath = prefix + ".ordinals.jsonl";
+    if (!draws.open(drawPath.c_str()) || !ordinals.open(ordinalPath.c_str())) {
+        *_report << "[Error] Failed to open export file for writing: " << prefix << ".*.jsonl" << endl;
+        return false;
     }
 
-    // Update the ordinalChance of the current list node with the cumulative sum passed to the function.
-    currentListNode->ordinalChance = ordinalSum;
-
-    // Calculate the new cumulative sum by adding the current node's average to the sum passed down.
-    double ordinalSummation = currentListNode->average + ordinalSum;
-    
-    // If there is a previous branch, recursively propagate the cumulative sum further back.
-    if (branchNode->_previous != nullptr){
-        propagate_statistical_tree(currentListNode->ordinal, ordinalSummation, branchNode->_previous);
+    for (int rank = 0; rank < _drawRange; rank++) {
+        int ball = _drawStats.rankedBall[rank];
+        draws.text("{\"rank\":");            draws.number(rank + 1);
+        draws.text(",\"ball\":");            draws.number(ball + 1);
+        draws.text(",\"total_drawn\":");     draws.number(_drawStats.totalTimesDrawn[ball]);
+        draws.text(",\"opportunities\":");   draws.number(_drawStats.drawOpportunities[ball]);
+        draws.text(",\"average\":");         draws.number(_drawStats.average[ball]);
+        draws.text(",\"ordinal_chance\":");  draws.number(_drawStats.ordinalChance[ball]);
+        draws.text(",\"ordinal_sigma\":");   draws.number(_drawStats.ordinalSigma[ball]);
+        draws.text(",\"last_drawn\":");      draws.number(_drawStats.lastDrawn[ball]);
+        draws.character('}');
+        draws.end_row();
     }
-    // If we've reached the base branch node (no previous branch), transfer the final cumulative sum to the draw numbers.
-    else {
-        DrawStatisticNode* drawList;  // Pointer to traverse the draw list.
-        drawList = _drawTreeStart;  // Start at the head of the draw list.
 
-        // Traverse to the draw number that corresponds to the final ordinance position.
-        listOrdinance = 1;
-        while(listOrdinance < currentListNode->ordinal){
-            drawList = drawList->_next;  // Move to the next draw number in the list.
-            listOrdinance++;
+    for (size_t level = 0; level < _ordinalTree.size(); level++) {
+        const OrdinalBranchNode& branch = _ordinalTree[level];
+        for (int rank = 0; rank < _drawRange; rank++) {
+            int ordinal = branch.rankedOrdinal[rank];
+            ordinals.text("{\"level\":");           ordinals.number(_retiredLevels.levels + level + 1);
+            ordinals.text(",\"rank\":");            ordinals.number(rank + 1);
+            ordinals.text(",\"ordinal\":");         ordinals.number(ordinal + 1);
+            ordinals.text(",\"sample_size\":");     ordinals.number(branch.sampleSize);
+            ordinals.text(",\"landed_total\":");    ordinals.number(branch.landedTotal[ordinal]);
+            ordinals.text(",\"opportunities\":");   ordinals.number(branch.opportunities[ordinal]);
+            ordinals.text(",\"average\":");         ordinals.number(branch.average[ordinal]);
+            ordinals.text(",\"ordinal_chance\":");  ordinals.number(branch.ordinalChance[ordinal]);
+            ordinals.character('}');
+            ordinals.end_row();
         }
+    }
 
-        // Update the ordinalChance of the draw number with the final cumulative sum.
-        drawList->ordinalChance = ordinalSummation;
+    if (!draws.close() || !ordinals.close()) {
+        *_report << "[Error] Failed to write export files: " << prefix << ".*.jsonl" << endl;
+        return false;
     }
-/* end of function
-Explanation of the Function:
-1. The function begins at a specific branch node and uses the given ordinance (position) to locate the 
-   corresponding ordinal list node.
-2. Once the target node is found, the function updates its ordinalChance field with the cumulative sum
-   passed down from previous levels.
-3. The function then adds the current node's average to the cumulative sum and continues propagating this
-   updated sum backward through the previous branches using a recursive call.
-4. When the function reaches the base branch node (where there is no previous branch), it transfers the
-   final cumulative sum to the corresponding draw number's ordinalChance field, effectively summarizing
-   the statistical data through the entire structure.
-
-5. The function is currently designed to handle the propagation of a single statistical metric (ordinal sum),
-    but can be extended to include additional metrics (e.g., sigma, standard deviation) as needed.
-
-6. This process is essential for calculating the overall likelihood of a draw number being drawn, based on
-   its ordinal position in various sorted lists.*/
-}
-
-void Analyse::collect_remaining_draws(ifstream& file, int startDraw) {
-    string line;               // String to hold each line read from the file.
-    int currentDraw = 0;       // Counter to track the current draw being processed.
-
-    // Clear the _remainingDraws vector to ensure no residual data from previous operations.
-    _remainingDraws.clear();
-
-    // Skip over draws until reaching the specified startDraw.
-    // This loop continues until currentDraw equals startDraw, effectively skipping earlier draws.
-    while (currentDraw < startDraw && getline(file, line)) {
-        currentDraw++;
-    }
-
-    // Collect the remaining draws starting from the specified draw index.
-    // The loop continues until either the end of the file is reached or the desired number of test draws (_testDrawCount) is collected.
-    while (getline(file, line) && _remainingDraws.size() < _testDrawCount) {
-        stringstream ss(line);    // Use a stringstream to parse the comma-separated values in the line.
-        string drawDate;          // Variable to store the draw date (which will be skipped).
-        std::vector<int> draw;    // Vector to hold the individual ball numbers for the current draw.
-
-        // Attempt to read and skip the draw date, which is the first value in the line.
-        // If the draw date cannot be read, output an error message and skip to the next line.
-        if (!getline(ss, drawDate, ',')) {
-            cerr << "[Error] Failed to read draw date from line: " << line << endl;
-            continue;
-        }
+    return true;
+}
 
-        // Collect and convert each ball number in the draw from a string to an integer.
-        // Add each valid ball number to the draw vector.
-        while (getline(ss, line, ',')) {
-            try {
-                draw.push_back(stoi(line)); // Convert the string to an integer and add it to the draw vector.
-            } catch (const invalid_argument& e) {
-                // If the conversion fails, output an error message and skip the rest of the line.
-                cerr << "[Error] Invalid ball number in line: " << line << endl;
-                break;
-            }
-        }
+bool Analyse::export_statistics_columns(const string& prefix) {
+/* Function to write the statistics in the binary columnar layout.
+The statistics are already stored as columns (struct-of-arrays), so most columns are a straight copy;
+only the rank columns are the inverse indexes. Both block sizes are fixed by the game geometry.*/
+
+    static const char padding[8] = {};
+    const size_t drawBlock = 3 * sizeof(double) * _drawRange + 4 * sizeof(int32_t) * _drawRange;
+    const size_t levelBlock = sizeof(int64_t) + 2 * sizeof(double) * _drawRange + 3 * sizeof(int32_t) * _drawRange;
+    const size_t drawPadding = (8 - drawBlock % 8) % 8, levelPadding = (8 - levelBlock % 8) % 8;
+    static_assert(sizeof(int) == sizeof(int32_t), "the int columns are copied as int32");
+
+    StatisticsColumnsHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "RACOLUMN", 8);
+    header.formatVersion = _columnsFormatVersion;
+    header.drawRange = _drawRange;
+    header.levels = static_cast<uint32_t>(_ordinalTree.size());
+    header.firstLevel = static_cast<uint32_t>(_retiredLevels.levels + 1);
+    header.blockAlignment = 8;
+    header.processedDraws = static_cast<uint64_t>(_processedDraws);
+    header.drawBlockBytes = drawBlock + drawPadding;
+    header.levelBlockBytes = levelBlock + levelPadding;
+
+    BufferedFile columns;
+    string path = prefix + ".columns";
+    if (!columns.open(path.c_str())) {
+        *_report << "[Error] Failed to open export file for writing: " << path << endl;
+        return false;
+    }
+    columns.bytes(&header, sizeof(header));
+    columns.bytes(_drawStats.average, sizeof(_drawStats.average));
+    columns.bytes(_drawStats.ordinalChance, sizeof(_drawStats.ordinalChance));
+    columns.bytes(_drawStats.ordinalSigma, sizeof(_drawStats.ordinalSigma));
+    columns.bytes(_drawStats.totalTimesDrawn, sizeof(_drawStats.totalTimesDrawn));
+    columns.bytes(_drawStats.drawOpportunities, sizeof(_drawStats.drawOpportunities));
+    columns.bytes(_drawStats.lastDrawn, sizeof(_drawStats.lastDrawn));
+    columns.bytes(_drawStats.ballRank, sizeof(_drawStats.ballRank));
+    columns.bytes(padding, drawPadding);
+    for (const OrdinalBranchNode& branch : _ordinalTree) {
+        int64_t sampleSize = branch.sampleSize;
+        columns.bytes(&sampleSize, sizeof(sampleSize));
+        columns.bytes(branch.average, sizeof(branch.average));
+        columns.bytes(branch.ordinalChance, sizeof(branch.ordinalChance));
+        columns.bytes(branch.landedTotal, sizeof(branch.landedTotal));
+        columns.bytes(branch.opportunities, sizeof(branch.opportunities));
+        columns.bytes(branch.ordinalRank, sizeof(branch.ordinalRank));
+        columns.bytes(padding, levelPadding);
+    }
+    if (!columns.close()) {
+        *_report << "[Error] Failed to write export file: " << path << endl;
+        return false;
+    }
+    return true;
+}
 
-        // After processing the line, check if the correct number of ball numbers were collected.
-        // If the correct number of balls is present, add the draw to _remainingDraws.
-        if (draw.size() == _drawCardSize) {
-            _remainingDraws.push_back(draw); // Add the fully processed draw to the _remainingDraws vector.
-        } else {
-            // If the number of balls is incorrect, output an error message and do not add the draw.
-            cerr << "[Error] Incorrect number of balls in draw: " << line << endl;
-        }
+bool Analyse::restore_snapshot(const char *path, int drawLimit) {
+// Function to restore the analyzer state from a snapshot file written by save_snapshot.
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    AnalyseSnapshotHeader header;
+    if (file.size() < sizeof(header)) return false;
+    memcpy(&header, file.data(), sizeof(header));
+    uint64_t expectedSize = sizeof(header) + sizeof(DrawStatisticTable) + sizeof(CoOccurrenceTable) + sizeof(RetiredOrdinalLevels)
+                          + static_cast<uint64_t>(header.levels) * sizeof(OrdinalBranchNode);
+    if (_recency.enabled())
+        expectedSize += (1 + static_cast<uint64_t>(header.levels)) * RecencyStatistics::state_bytes(_recency);
+    if (memcmp(header.magic, "RASNAPST", 8) != 0
+        || header.formatVersion != _snapshotFormatVersion
+        || header.drawRange != _drawRange
+        || header.cardSize != _drawCardSize
+        || header.drawSampleSize != static_cast<uint32_t>(_drawSampleSize)
+        || header.ordinalSampleSize != static_cast<uint32_t>(_ordinalSampleSize)
+        || header.drawTableBytes != sizeof(DrawStatisticTable)
+        || header.coOccurrenceBytes != sizeof(CoOccurrenceTable)
+        || header.levelBytes != sizeof(OrdinalBranchNode)
+        || header.retiredBytes != sizeof(RetiredOrdinalLevels)
+        || header.maxLevels != static_cast<uint32_t>(_ordinalGrowth.maxLevels)
+        || header.retireSampleSize != static_cast<uint32_t>(_ordinalGrowth.retireSampleSize)
+        || header.memoryBudget != _ordinalGrowth.memoryBudget
+        || header.recencyWindow != static_cast<uint32_t>(_recency.window)
+        || header.ranking != static_cast<uint32_t>(_recency.ranking)
+        || header.recencyDecay != _recency.decay
+        || header.levels == 0
+        || file.size() != expectedSize) {
+        *_report << "[Warning] Ignoring snapshot written by another build: " << path << endl;
+        return false;
+    }
+    if (header.processedDraws > static_cast<uint64_t>(std::max(0, drawLimit))
+        || header.historyFingerprint != history_fingerprint(header.processedDraws)) {
+        *_report << "[Warning] Ignoring snapshot that does not match the draw history: " << path << endl;
+        return false;
     }
 
+    const char *block = file.data() + sizeof(header);
+    memcpy(&_drawStats, block, sizeof(DrawStatisticTable));
+    block += sizeof(DrawStatisticTable);
+    memcpy(&_coOccurrence, block, sizeof(CoOccurrenceTable));
+    block += sizeof(CoOccurrenceTable);
+    memcpy(&_retiredLevels, block, sizeof(RetiredOrdinalLevels));
+    block += sizeof(RetiredOrdinalLevels);
+    _ordinalTree.resize(header.levels);
+    memcpy(_ordinalTree.data(), block, header.levels * sizeof(OrdinalBranchNode));
+    block += header.levels * sizeof(OrdinalBranchNode);
+    auto readRecency = [this, &block](RecencyStatistics& recency) {
+        recency.reset(_recency);
+        memcpy(&recency.columns, block, sizeof(RecencyColumns));
+        block += sizeof(RecencyColumns);
+        std::copy(block, block + recency.ring.size(), recency.ring.begin());
+        block += recency.ring.size();
+    };
+    if (_recency.enabled()) {
+        readRecency(_drawRecency);
+        _ordinalRecency.resize(header.levels);
+        for (RecencyStatistics& level : _ordinalRecency)
+            readRecency(level);
+    }
+    _ordinalBranchTotalNodes = _retiredLevels.levels + static_cast<int>(header.levels);
+    _seeded = header.seeded != 0;
+    _totalEvents = header.totalEvents;
+    _processedDraws = static_cast<int>(header.processedDraws);
+    for (int slot = 0; slot < _drawCardSize; slot++)
+        _lastDraw.back()[slot] = header.lastDraw[slot];
+    return true;
+}
+
+void Analyse::collect_remaining_draws(int startDraw) {
+    // The draws were validated when the history was loaded, so they are copied straight from the draw array.
+    size_t first = std::min(static_cast<size_t>(startDraw), _drawHistory.size());
+    size_t last = std::min(first + static_cast<size_t>(_testDrawCount), _drawHistory.size());
+    _remainingDraws.assign(_drawHistory.begin() + first, _drawHistory.begin() + last);
+
     // Output a debug message indicating how many draws were collected for testing.
-    cout << "[Debug] Collected " << _remainingDraws.size() << " draws for testing." << endl;
+    LOG_DEBUG("Collected {} draws for testing.", _remainingDraws.size());
 }
 
 void Analyse::sort_ordinal_lists(){
-/* Function to sort all ordinal lists within the linked ordinalBranch structure.
-Currently, this function sorts each list by the average values, but it is designed 
+/* Function to sort all ordinal lists within the ordinal tree.
+Currently, this function sorts each list by the average values (lifetime, windowed or decayed), but it is designed 
 with the intention to support sorting by other statistical metrics in the future.*/
 
-    OrdinalBranchNode *Current = _ordinalTreeStart;  // Start at the head of the ordinal branch list.
-    
-    // Traverse through each ordinal branch in the linked list.
-    while(Current != NULL)
+    PROFILE_SCOPE(OrdinalSort);
+
+    // Traverse through each ordinal level in the arena.
+    for (size_t level = 0; level < _ordinalTree.size(); level++)
     {
-        // Sort the current ordinal list by average values.
+        // Sort the current ordinal list by the ranking averages (lifetime, windowed or decayed).
         // TODO: Extend the sorting mechanism to allow sorting by other statistical metrics.
-        sort_ordinal_average(Current);
-
-        // Move to the next ordinal branch in the list.
-        Current = Current->_next;
+        sort_ordinal_average(_ordinalTree[level], ordinal_ranking_average(level));
     }
 /* end of function
 Explanation of the Function:
-1. The function starts by pointing to the first ordinal branch in the linked list (indicated by `_ordinalBranchStart`).
-2. It then iterates through each ordinal branch in the list, using a loop that continues until the end of the list is reached (`Current != NULL`).
-3. For each ordinal branch, the function calls `sort_ordinal_average()`, which sorts the ordinal list nodes within that branch by their average values.
-4. After sorting the current branch's list, the function advances to the next branch in the list by updating the `Current` pointer.
+1. The function starts at the first ordinal level in the arena (`_ordinalTree`).
+2. It then iterates through each level in order until the end of the arena is reached.
+3. For each level, the function calls `sort_ordinal_average()`, which re-ranks the ordinals within that level by their average values.
+4. After sorting the current level's list, the function advances to the next level.
 5. The function is designed to be easily extendable. Future versions could include additional sorting functions, such as:
    - `sort_ordinal_by_sigma(Current)`: Sort by the sigma (standard deviation) of the values.
    - `sort_ordinal_by_median(Current)`: Sort by the median of the values.
    - `sort_ordinal_by_custom_metric(Current, customMetricFunction)`: Sort by a custom metric defined by a function pointer or lambda expression.*/
 }
 
-void Analyse::calculate_ordinal_event(int ordinance, OrdinalBranchNode*& Node){
+void Analyse::calculate_ordinal_event(int ordinance){
 /* Function to calculate and record the statistical event for a specific ordinal position (ordinance).
 This function updates the statistical data (e.g., landed total, opportunities, average) for a drawn number 
-within the ordinal lists. It propagates these updates through the hierarchy of ordinal branches.
-If a branch's sample size exceeds a predefined threshold, a new ordinal branch is created.*/
-
-    // Start at the head of the ordinal list in the current branch.
-    OrdinalStatisticNode* currentListNode = Node->listNode;
+within the ordinal lists. It propagates these updates through every level of the ordinal tree in a loop.
+If the last level's sample size exceeds a predefined threshold, a new level is appended.*/
 
-    int OrdinalListLocation = 1; // Counter to track the location within the ordinal list.
-    
-    // Traverse the ordinal list to find the node corresponding to the given ordinance.
-    while(currentListNode != nullptr)
+    PROFILE_COUNT(OrdinalEvents, 1);
+    ordinance = _retiredLevels.liveSlot[ordinance - 1] + 1; // Across the retired levels in one step.
+    for (int depth = 0; ; depth++)
     {
-        if(currentListNode->ordinal == ordinance)
-        {
-            // Update the statistical data for the node where the ordinal matches.
-            currentListNode->landedTotal++; // Increment the count of times this ordinal position has been landed on.
-            currentListNode->opportunities++; // Increment the number of opportunities for this ordinal position.
-            
-            // Recalculate the average for this ordinal position.
-            currentListNode->average = static_cast<double>(currentListNode->landedTotal) 
-                                       / static_cast<double>(currentListNode->opportunities);
-            
-            // Increment the sample size for the current branch.
-            Node->sampleSize++;
-
-            // If there is a next branch in the sequence, recursively update the corresponding ordinal node.
-            if(Node->_next != nullptr){
-                calculate_ordinal_event(OrdinalListLocation, Node->_next);
-            }
-            // If there is no next branch and the sample size exceeds the threshold, create a new branch.
-            else if (Node->sampleSize > _ordinalSampleSize)
-            {
-                _ordinalBranchTotalNodes++; // Track the total number of ordinal branches.
-                
-                // Create a new ordinal branch.
-                Node->_next = new OrdinalBranchNode;
-                Node->_next->sampleSize = 0;
-                Node->_next->_next = nullptr;
-                Node->_next->_previous = Node;
-
-                // Initialize the new ordinal list in the new branch.
-                initialize_ordinal_list(Node->_next->listNode);
-
-                // Recursively update the new branch with the current ordinal event.
-                calculate_ordinal_event(OrdinalListLocation, Node->_next);
-            }
+        OrdinalBranchNode& Node = _ordinalTree[depth];
+        int ordinal = ordinance - 1;
 
-            // Exit the function immediately, as there is no need to continue further.
-            return;
+        // Update the statistical data for the ordinal.
+        Node.landedTotal[ordinal]++; // Increment the count of times this ordinal position has been landed on.
+        Node.opportunities[ordinal]++; // Increment the number of opportunities for this ordinal position.
+        
+        // Recalculate the average for this ordinal position.
+        Node.average[ordinal] = static_cast<double>(Node.landedTotal[ordinal]) 
+                              / static_cast<double>(Node.opportunities[ordinal]);
+        
+        // Increment the sample size for the current level.
+        Node.sampleSize++;
+        if (_recency.enabled())
+            _ordinalRecency[depth].record(ordinal, 1);
+
+        // The position held by this ordinal is what the next level references.
+        ordinance = Node.ordinalRank[ordinal] + 1;
+
+        // If this is the last level, stop unless the sample size exceeds the threshold,
+        // in which case a new level is created and the event carries on into it.
+        if (depth + 1 == static_cast<int>(_ordinalTree.size())) {
+            if (Node.sampleSize <= _ordinalSampleSize || !ordinal_tree_can_grow())
+                return;
+            add_ordinal_level(); // May grow the arena; 'Node' is not used past this point.
         }
-
-        // Move to the next node in the ordinal list.
-        currentListNode = currentListNode->_next;
-        OrdinalListLocation++; // Increment the location counter.
     }
 /*	end of function
 Explanation of the Function:
-1. The function starts by traversing the ordinal list within the current branch to find the node that matches the given ordinance (position).
-2. Once the matching node is found, the function updates its statistical data, including:
+1. The function looks up the slot that holds the given ordinance and the position that ordinal currently has in the sorted list.
+2. It then updates the statistical data of that slot, including:
    - Incrementing the `landedTotal` (number of times the position has been landed on).
    - Incrementing the `opportunities` (number of chances the position had to be drawn).
    - Recalculating the `average`, which is the ratio of `landedTotal` to `opportunities`.
-3. The function then increments the `sampleSize` for the current branch.
-4. If the current branch has a subsequent branch in the sequence, the function recursively calls itself to update the corresponding node in the next branch.
-5. If there is no next branch and the `sampleSize` exceeds the predefined threshold (`_ordinalSampleSize`), the function creates a new ordinal branch:
-   - A new `ordinalBranch` is instantiated, linked to the current branch.
-   - The new branch's ordinal list is initialized, and the function recursively updates the new branch with the current ordinal event.
-6. This function ensures that the statistical data is propagated through all relevant branches, accurately reflecting the impact of the drawn number across the entire structure.
-7. This setup is designed to handle dynamic growth in the number of branches as more draw events are processed, keeping the analysis structure scalable and adaptable.
+3. The function then increments the `sampleSize` for the current level.
+4. The position of the ordinal becomes the ordinance for the next level, and the loop moves on to that level.
+5. If there is no next level and the `sampleSize` exceeds the predefined threshold (`_ordinalSampleSize`), the function appends a new level:
+   - A new `OrdinalBranchNode` is initialized at the end of the arena.
+   - The loop carries on into the new level and records the current ordinal event there too.
+6. This function ensures that the statistical data is propagated through all relevant levels, accurately reflecting the impact of the drawn number across the entire structure.
+7. This setup is designed to handle dynamic growth in the number of levels as more draw events are processed, keeping the analysis structure scalable and adaptable.
 TODO: Consider extending this function to handle additional statistical metrics (e.g., sigma, standard deviation, etc.) and update the comments accordingly.*/
 }
 
-void Analyse::initialize_ordinal_list(OrdinalStatisticNode*& Head){
-/* Function to initialize a linked list of 49 ordinalListNode elements in sequential order.
-Each node in the list represents an ordinal position and is initialized with default values. */
+void Analyse::initialize_ordinal_list(OrdinalBranchNode& Branch){
+/* Function to initialize the 49 ordinal slots of a level in sequential order.
+Each slot represents an ordinal position and is initialized with default values. */
 
-    // Step 1: Initialize the head node of the linked list.
-    Head = new OrdinalStatisticNode;
-    if (!Head) {
-        cerr << "[Error] Memory allocation failed for the head node." << endl;
-        return;
+    for (int ordinal = 0; ordinal < _drawRange; ++ordinal) {
+        Branch.average[ordinal] = 0.0;           // Initialize average to 0.0.
+        Branch.opportunities[ordinal] = 0;       // Initialize opportunities to 0.
+        Branch.ordinalChance[ordinal] = 0.0;     // Initialize ordinalChance to 0.0.
+        Branch.landedTotal[ordinal] = 0;         // Initialize landedTotal to 0.
+
+        // The list starts out sorted in ordinal order.
+        Branch.rankedOrdinal[ordinal] = ordinal;
+        Branch.ordinalRank[ordinal] = ordinal;
     }
+    Branch.sampleSize = 0;
+}
 
-    // Step 2: Pointer to traverse and build the list.
-    OrdinalStatisticNode* currentList = Head;
-
-    // Step 3: Initialize each node in the list with sequential ordinal values.
-    for (int i = 1; i <= 49; ++i) {
-        currentList->ordinal = i;             // Assign ordinal value sequentially from 1 to 49.
-        currentList->average = 0.0;           // Initialize average to 0.0.
-        currentList->isDrawn = false;         // Initialize isDrawn to false.
-        currentList->opportunities = 0;       // Initialize opportunities to 0.
-        currentList->ordinalChance = 0.0;     // Initialize ordinalChance to 0.0.
-        currentList->landedTotal = 0;         // Initialize landedTotal to 0.
-
-        // Step 4: Create the next node if we're not at the last element.
-        if (i < 49) {
-            currentList->_next = new OrdinalStatisticNode;
-            if (!currentList->_next) {
-                cerr << "[Error] Memory allocation failed at position " << i << endl;
-                break;  // Stop the loop if memory allocation fails.
-            }
-            currentList = currentList->_next; // Move to the next node in the list.
-        } else {
-            // Step 5: Set the last node's _next pointer to nullptr to indicate the end of the list.
-            currentList->_next = nullptr;
-        }
+size_t Analyse::ordinal_level_bytes() const {
+    size_t bytes = sizeof(OrdinalBranchNode);
+    if (_recency.enabled())
+        bytes += sizeof(RecencyStatistics) + static_cast<size_t>(_recency.window) * 2 * _drawRange;
+    return bytes;
+}
+
+bool Analyse::ordinal_tree_can_grow() const {
+    size_t live = _ordinalTree.size();
+    if (_ordinalGrowth.maxLevels > 0 && _retiredLevels.levels + static_cast<int>(live) >= _ordinalGrowth.maxLevels)
+        return false;
+    if (_ordinalGrowth.memoryBudget > 0 && (live + 1) * ordinal_level_bytes() > _ordinalGrowth.memoryBudget)
+        return false;
+    return true;
+}
+
+size_t Analyse::ordinal_live_level_limit() const {
+    size_t limit = 0;
+    if (_ordinalGrowth.maxLevels > 0)
+        limit = static_cast<size_t>(_ordinalGrowth.maxLevels);
+    if (_ordinalGrowth.memoryBudget > 0) {
+        size_t budgetLevels = std::max<size_t>(1, _ordinalGrowth.memoryBudget / ordinal_level_bytes());
+        limit = limit ? std::min(limit, budgetLevels) : budgetLevels;
     }
-/* end of function
-Explanation of the Function:
-1. **Head Node Initialization:**
-   - The function starts by creating and initializing the head node of the linked list.
-   - Memory allocation is checked to ensure successful creation. If allocation fails, an error is reported and the function exits.
-2. **Sequential Initialization:**
-   - A loop runs from 1 to 49, initializing each `ordinalListNode` with a sequential ordinal value and default statistics.
-   - The fields `average`, `isDrawn`, `opportunities`, `ordinalChance`, and `landedTotal` are all initialized to their default values.
-3. **Linked List Construction:**
-   - For each node, the function allocates memory for the next node in the list, linking them together sequentially.
-   - If memory allocation fails at any point, the function outputs an error message and stops further processing.
-4. **End of the List:**
-   - The last node's `_next` pointer is set to `nullptr`, indicating the end of the linked list.
-**Advantages of the Refactored Function:**
-- **Simplicity:** The function is straightforward and easy to understand, as it initializes the list in a simple, sequential order without unnecessary complexity.
-- **Clarity:** The removal of random generation simplifies the function's purpose, making it clear that the list is ordered sequentially.
-- **Efficiency:** This approach avoids the overhead of shuffling, making the function more efficient for cases where a simple ordered list is sufficient.*/
+    return limit;
 }
 
-void Analyse::reset_flags(){
-    DrawStatisticNode* listNumber = _drawTreeStart;
-    while (listNumber != NULL) {
-        listNumber->isDrawn = false;
-        listNumber = listNumber->_next;
+void Analyse::retire_oldest_ordinal_level() {
+/* Function to retire the oldest live level once it has stabilized.
+The level is frozen as it stands. Its sorted order is composed into the forward mapping, so later
+updates skip it, and its metrics are added to the sums correlate_data carries down to the draw list,
+so its contribution to ordinalChance and ordinalSigma is kept. Its block is then removed from the front of the arena.*/
+
+    const OrdinalBranchNode& oldest = _ordinalTree.front();
+    RetiredOrdinalLevels& retired = _retiredLevels;
+    int drawRank[_drawRange];
+    double own[OrdinalMetricCount][_drawRange];
+    double metricSum[OrdinalMetricCount][_drawRange];
+    ordinal_level_metrics(oldest, own);
+
+    for (int rank = 0; rank < _drawRange; rank++) {
+        // Forward: the slot an update lands on in the oldest level becomes, through its rank, the slot in the next one.
+        retired.liveSlot[rank] = oldest.ordinalRank[retired.liveSlot[rank]];
+
+        // Down: rank 'rank' of the oldest level holds this ordinal, which references that position below it.
+        int ordinal = oldest.rankedOrdinal[rank];
+        drawRank[rank] = retired.drawRank[ordinal];
+        for (int metric = 0; metric < OrdinalMetricCount; metric++)
+            metricSum[metric][rank] = own[metric][ordinal] + retired.metricSum[metric][ordinal];
+    }
+    std::copy(drawRank, drawRank + _drawRange, retired.drawRank);
+    memcpy(retired.metricSum, metricSum, sizeof(metricSum));
+    retired.levels++;
+
+    _ordinalTree.erase(_ordinalTree.begin());
+    if (_recency.enabled())
+        _ordinalRecency.erase(_ordinalRecency.begin());
+    PROFILE_COUNT(OrdinalLevelsRetired, 1);
+}
+
+void Analyse::display_ordinal_memory() {
+// Function to display what the ordinal tree occupies. Every level is one fixed-size block.
+    size_t live = _ordinalTree.size();
+    *_report << "Ordinal tree memory: " << live << " live level(s) x " << sizeof(OrdinalBranchNode) << " bytes = "
+              << live * sizeof(OrdinalBranchNode) << " bytes (arena reserved " << _ordinalTree.capacity() * sizeof(OrdinalBranchNode)
+              << " bytes); " << _retiredLevels.levels << " retired level(s) summarized in " << sizeof(RetiredOrdinalLevels) << " bytes." << std::endl;
+    if (_recency.enabled())
+        *_report << "Recency statistics: " << live + 1 << " list(s) x " << ordinal_level_bytes() - sizeof(OrdinalBranchNode)
+                  << " bytes (window " << _recency.window << " draws, decay " << _recency.decay << ")." << std::endl;
+    if (_debugMode)
+        for (size_t level = 0; level < live; level++)
+            *_report << "  Ordinal Level " << _retiredLevels.levels + level + 1 << ": " << sizeof(OrdinalBranchNode)
+                      << " bytes, sample size " << _ordinalTree[level].sampleSize << std::endl;
+}
+
+int Analyse::add_ordinal_level(){
+/* Function to append a new ordinal level to the end of the ordinal tree arena.
+Levels are plain fixed-size blocks, so growing the tree is a single append to the arena
+and the new level sits right behind the previous one in memory. */
+
+    PROFILE_ONLY(size_t capacity = _ordinalTree.capacity());
+    _ordinalTree.emplace_back();
+    PROFILE_GROWTH(OrdinalTree, _ordinalTree, capacity);
+    PROFILE_COUNT(OrdinalLevelsCreated, 1);
+    initialize_ordinal_list(_ordinalTree.back());
+    if (_recency.enabled()) {
+        _ordinalRecency.emplace_back();
+        _ordinalRecency.back().reset(_recency);
     }
+    _ordinalBranchTotalNodes = _retiredLevels.levels + static_cast<int>(_ordinalTree.size()); // Track the total number of ordinal levels.
+    return static_cast<int>(_ordinalTree.size()) - 1;
+}
+
+void Analyse::reset_flags(){
+    std::fill(_drawStats.isDrawn, _drawStats.isDrawn + _drawRange, false);
 }
 
-void Analyse::calculate_draw_event(DrawStatisticNode*& Number){
+void Analyse::calculate_draw_event(int ball){
 /* Function to record a draw event for a specific number.
 This function updates key statistics for the number being drawn, such as the total times drawn,
 draw opportunities, and average. It also marks the number as drawn and records when it was last drawn.
 The function is designed to be extendable, allowing for additional calculations to be added in the future. */
 
     // Increment the total number of times this number has been drawn.
-    Number->totalTimesDrawn++;
+    _drawStats.totalTimesDrawn[ball]++;
 
     // Increment the number of opportunities this number had to be drawn.
-    Number->drawOpportunities++;
+    _drawStats.drawOpportunities[ball]++;
+
+    // Recalculate the average based on the updated totals.
+    // The average is the ratio of total times drawn to the number of opportunities.
+    _drawStats.average[ball] = static_cast<double>(_drawStats.totalTimesDrawn[ball]) / static_cast<double>(_drawStats.drawOpportunities[ball]);
+
+    // Record the draw number in which this number was last drawn.
+    // This value is set to the position of the current draw in the history.
+    _drawStats.lastDrawn[ball] = _processedDraws;
+
+    // Mark the number as drawn in the current draw.
+    _drawStats.isDrawn[ball] = true;
+
+/* TODO: Extend this function to include additional statistical calculations in the future.
+Potential future calculations might include:
+- Update sigma (standard deviation) based on the new draw event.
+- Calculate and update any custom metrics that need to be tracked for each draw.
+- Log or record additional metadata related to the draw event, such as draw date or position in the draw.*/
+}
+
+void Analyse::record_co_occurrence(const DrawRecord& draw){
+/* Function to add a draw to the pair and triple counts.
+The draw's numbers become an indicator row, which is added to the pair matrix row of every number drawn;
+the rows are padded to whole cache lines, so the compiler turns each add into a few vector adds. The
+triples are then counted from the sorted numbers, one increment per triple the draw holds.*/
+
+    PROFILE_SCOPE(CoOccurrence);
+    CoOccurrenceTable& table = _coOccurrence;
+    alignas(64) uint32_t drawn[_pairStride] = {};
+    int balls[_drawCardSize];
+    int count = 0;
+
+    // The numbers of the draw, 0-based and ascending; a repeated number is counted once.
+    for (int slot = 0; slot < _drawCardSize; slot++)
+        drawn[draw.balls[slot] - 1] = 1;
+    for (int ball = 0; ball < _drawRange; ball++)
+        if (drawn[ball])
+            balls[count++] = ball;
+
+    for (int i = 0; i < count; i++) {
+        uint32_t *row = table.pairDrawn[balls[i]];
+        for (int column = 0; column < _pairStride; column++)
+            row[column] += drawn[column];
+    }
+    for (int k = 2; k < count; k++) {
+        for (int j = 1; j < k; j++) {
+            uint32_t *triples = table.tripleDrawn + triple_index(0, balls[j], balls[k]);
+            for (int i = 0; i < j; i++)
+                triples[balls[i]]++;
+        }
+    }
+    table.draws++;
+}
+
+double Analyse::pair_average(int a, int b) const {
+    if (_coOccurrence.draws == 0) return 0.0;
+    return static_cast<double>(_coOccurrence.pairDrawn[a][b]) / static_cast<double>(_coOccurrence.draws);
+}
+
+double Analyse::triple_average(int a, int b, int c) const {
+    if (_coOccurrence.draws == 0) return 0.0;
+    // Put the triple in ascending order for its colex rank.
+    if (a > b) std::swap(a, b);
+    if (b > c) std::swap(b, c);
+    if (a > b) std::swap(a, b);
+    return static_cast<double>(_coOccurrence.tripleDrawn[triple_index(a, b, c)]) / static_cast<double>(_coOccurrence.draws);
+}
+
+std::vector<GroupStatistic> Analyse::top_pairs(int count) const {
+/* Function to find the pairs drawn most often.
+The upper triangle of the pair matrix is walked in colex order and offered to a bounded heap keyed by
+the count and the colex rank; a pair is compared against the heap's weakest entry once, so the query is
+one pass over the 1,176 pairs.*/
+
+    BoundedCardHeap<HigherCardScore> heap(static_cast<size_t>(std::max(0, count)));
+    uint64_t rank = 0;
+    for (int b = 1; b < _drawRange; b++) {
+        for (int a = 0; a < b; a++, rank++) {
+            double drawn = _coOccurrence.pairDrawn[a][b];
+            if (heap.admits(drawn, rank))
+                heap.push(ScoredCard{drawn, rank, {a, b}});
+        }
+    }
+    std::vector<GroupStatistic> pairs;
+    for (const ScoredCard& pair : heap.sorted()) {
+        int a = pair.balls[0], b = pair.balls[1];
+        pairs.push_back(GroupStatistic{2, {a + 1, b + 1, 0}, _coOccurrence.pairDrawn[a][b], pair_average(a, b)});
+    }
+    return pairs;
+}
+
+std::vector<GroupStatistic> Analyse::top_triples(int count) const {
+/* Function to find the triples drawn most often.
+The triple table is walked in storage (colex) order, so the rank of a triple is its index and the scan
+reads the table front to back; as with the pairs, only triples that beat the weakest kept one touch the heap.*/
+
+    BoundedCardHeap<HigherCardScore> heap(static_cast<size_t>(std::max(0, count)));
+    const uint32_t *tripleDrawn = _coOccurrence.tripleDrawn;
+    uint64_t rank = 0;
+    for (int c = 2; c < _drawRange; c++) {
+        for (int b = 1; b < c; b++) {
+            for (int a = 0; a < b; a++, rank++) {
+                double drawn = tripleDrawn[rank];
+                if (heap.admits(drawn, rank))
+                    heap.push(ScoredCard{drawn, rank, {a, b, c}});
+            }
+        }
+    }
+    std::vector<GroupStatistic> triples;
+    for (const ScoredCard& triple : heap.sorted()) {
+        int a = triple.balls[0], b = triple.balls[1], c = triple.balls[2];
+        triples.push_back(GroupStatistic{3, {a + 1, b + 1, c + 1}, tripleDrawn[triple.rank], triple_average(a, b, c)});
+    }
+    return triples;
+}
+
+CardGroupScore Analyse::card_group_score(const int *balls, int count) const {
+// Function to sum the averages of every pair and every triple of a card's numbers.
+    CardGroupScore score = {0.0, 0.0};
+    for (int k = 0; k < count; k++) {
+        for (int j = 0; j < k; j++) {
+            score.pairs += pair_average(balls[j] - 1, balls[k] - 1);
+            for (int i = 0; i < j; i++)
+                score.triples += triple_average(balls[i] - 1, balls[j] - 1, balls[k] - 1);
+        }
+    }
+    return score;
+}
+
+bool Analyse::validate_draw_combination(Card PossibleCombinationCard)
+{
+	/*there are a set of statistical annomolies that relate to winning draws, 
+	this function will invalidate any combination without these traits.
+	It must have a Prime Number, an even and odd number, properly ranged in value,
+	the sum is between a certain range. Only the main numbers are checked.*/ 
+	int Summation = 0;
+	for (int i = 0; i < _drawMainNumbers; i++)
+		Summation = Summation + PossibleCombinationCard[i];
+	return validate_card_mask(card_mask(PossibleCombinationCard, _drawMainNumbers), Summation);
+}
+bool Analyse::prime_number_check(Card num)
+{
+	return (card_mask(num, _drawMainNumbers) & PrimeBallMask) != 0;
+}
+
+CardMask Analyse::card_mask(const int *balls, int count)
+{
+	CardMask mask = 0;
+	for (int i = 0; i < count; i++)
+		mask |= 1ULL << balls[i];
+	return mask;
+}
+
+bool Analyse::validate_card_mask(CardMask mainNumbers, int sum)
+{
+	// A prime number, an even count, a low count and a sum within the game's ranges
+	// (for Lotto 649: 2-4 even numbers, 2-4 low numbers (under 25), a sum of 121-200),
+	// at most Game::DecadeMax numbers in any decade and at least one decade left empty.
+	if (!(mainNumbers & PrimeBallMask))
+		return false;
+	int Even = popcount64(mainNumbers & EvenBallMask);
+	if (Even < Game::EvenMin || Even > Game::EvenMax)
+		return false;
+	if (sum < Game::SumMin || sum > Game::SumMax)
+		return false;
+	int Low = popcount64(mainNumbers & LowBallMask);
+	if (Low < Game::LowMin || Low > Game::LowMax)
+		return false;
+	int filledDecades = 0;
+	for (CardMask decade : DecadeBallMask) {
+		int inDecade = popcount64(mainNumbers & decade);
+		if (inDecade > Game::DecadeMax)
+			return false;
+		filledDecades += (inDecade != 0);
+	}
+	return filledDecades < _drawDecades;
+}
+
+#if defined(__AVX2__) && !(defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__))
+// Popcount of each 64-bit lane using the nibble lookup table trick.
+static inline __m256i popcount_epi64_avx2(__m256i v)
+{
+	const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+	                                        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i nibble = _mm256_set1_epi8(0x0f);
+	__m256i low = _mm256_and_si256(v, nibble);
+	__m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+	__m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+	return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+// Lanes whose value lies outside [low, high].
+static inline __m256i outside_epi64_avx2(__m256i v, long long low, long long high)
+{
+	return _mm256_or_si256(_mm256_cmpgt_epi64(_mm256_set1_epi64x(low), v),
+	                       _mm256_cmpgt_epi64(v, _mm256_set1_epi64x(high)));
+}
+#endif
+
+void Analyse::validate_card_batch(const CardMask *mainNumbers, const int *sums, size_t count, uint8_t *valid)
+{
+	size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+	// Eight cards per iteration; every rule is a lane mask.
+	for (; i + 8 <= count; i += 8) {
+		__m512i masks = _mm512_loadu_si512(mainNumbers + i);
+		__m512i sum = _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sums + i)));
+		__m512i even = _mm512_popcnt_epi64(_mm512_and_si512(masks, _mm512_set1_epi64(EvenBallMask)));
+		__m512i low = _mm512_popcnt_epi64(_mm512_and_si512(masks, _mm512_set1_epi64(LowBallMask)));
+		__mmask8 ok = _mm512_test_epi64_mask(masks, _mm512_set1_epi64(PrimeBallMask));
+		ok &= _mm512_cmp_epu64_mask(_mm512_sub_epi64(even, _mm512_set1_epi64(Game::EvenMin)), _mm512_set1_epi64(Game::EvenMax - Game::EvenMin), _MM_CMPINT_LE);
+		ok &= _mm512_cmp_epu64_mask(_mm512_sub_epi64(low, _mm512_set1_epi64(Game::LowMin)), _mm512_set1_epi64(Game::LowMax - Game::LowMin), _MM_CMPINT_LE);
+		ok &= _mm512_cmp_epu64_mask(_mm512_sub_epi64(sum, _mm512_set1_epi64(Game::SumMin)), _mm512_set1_epi64(Game::SumMax - Game::SumMin), _MM_CMPINT_LE);
+		__mmask8 allFilled = 0xff;
+		for (CardMask decade : DecadeBallMask) {
+			__m512i inDecade = _mm512_popcnt_epi64(_mm512_and_si512(masks, _mm512_set1_epi64(decade)));
+			ok &= _mm512_cmp_epu64_mask(inDecade, _mm512_set1_epi64(Game::DecadeMax), _MM_CMPINT_LE);
+			allFilled &= _mm512_test_epi64_mask(inDecade, inDecade);
+		}
+		ok &= ~allFilled;
+		for (int lane = 0; lane < 8; lane++)
+			valid[i + lane] = (ok >> lane) & 1;
+	}
+#elif defined(__AVX2__)
+	// Four cards per iteration; a lane is all ones when the card breaks a rule.
+	for (; i + 4 <= count; i += 4) {
+		__m256i masks = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mainNumbers + i));
+		__m256i sum = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(sums + i)));
+		__m256i zero = _mm256_setzero_si256();
+		__m256i bad = _mm256_cmpeq_epi64(_mm256_and_si256(masks, _mm256_set1_epi64x(PrimeBallMask)), zero);
+		bad = _mm256_or_si256(bad, outside_epi64_avx2(popcount_epi64_avx2(_mm256_and_si256(masks, _mm256_set1_epi64x(EvenBallMask))), Game::EvenMin, Game::EvenMax));
+		bad = _mm256_or_si256(bad, outside_epi64_avx2(popcount_epi64_avx2(_mm256_and_si256(masks, _mm256_set1_epi64x(LowBallMask))), Game::LowMin, Game::LowMax));
+		bad = _mm256_or_si256(bad, outside_epi64_avx2(sum, Game::SumMin, Game::SumMax));
+		__m256i anyEmpty = zero;
+		for (CardMask decade : DecadeBallMask) {
+			__m256i inDecade = popcount_epi64_avx2(_mm256_and_si256(masks, _mm256_set1_epi64x(decade)));
+			bad = _mm256_or_si256(bad, _mm256_cmpgt_epi64(inDecade, _mm256_set1_epi64x(Game::DecadeMax)));
+			anyEmpty = _mm256_or_si256(anyEmpty, _mm256_cmpeq_epi64(inDecade, zero));
+		}
+		bad = _mm256_or_si256(bad, _mm256_cmpeq_epi64(anyEmpty, zero));
+		int badLanes = _mm256_movemask_pd(_mm256_castsi256_pd(bad));
+		for (int lane = 0; lane < 4; lane++)
+			valid[i + lane] = !((badLanes >> lane) & 1);
+	}
+#endif
+	// Scalar kernel for the remainder (or everything on builds without vector support).
+	for (; i < count; i++)
+		valid[i] = validate_card_mask(mainNumbers[i], sums[i]);
+}
+
+long long Analyse::generate_combination_block(int first, int second, std::string& out, long long& valid)
+{
+	// Generates the cards of one block in the same order as the nested loops of a full sequential run.
+	// Numbers are written from a small table of pre-formatted strings instead of to_string().
+	static const std::array<std::string, _drawRange + 1> BallText = []() {
+		std::array<std::string, _drawRange + 1> text;
+		for (int ball = 0; ball <= _drawRange; ball++)
+			text[ball] = std::to_string(ball);
+		return text;
+	}();
+	long long generated = 0;
+	CardMask lastMasks[_drawRange];   // Main-number masks of the cards that differ only in their last main number.
+	int lastSums[_drawRange];         // Main-number sums of the same cards.
+	uint8_t lastValid[_drawRange];    // Validation result for each last main number.
+
+	auto extend = [](const CardPrefix& prefix, int number, int) { return prefix.with(number); };
+	auto writeCard = [&](const CardPrefix& card) {
+		for (int j = 0; j < _drawCardSize; ++j) {
+			if (j) out += ' ';
+			out += BallText[card.balls[j]];
+		}
+		out += '\n';
+	};
+
+	// Only the main numbers are validated, so the bonus numbers never change the verdict:
+	// validate every choice of the last main number in one batch and expand the valid ones over every bonus choice.
+	auto expand = [&](const CardPrefix& prefix) {
+		int low = prefix.balls[prefix.size - 1] + 1;
+		int high = _drawRange - Game::BonusNumbers;
+		int candidates = 0;
+		for (int last = low; last <= high; last++, candidates++) {
+			lastMasks[candidates] = prefix.mask | (1ULL << last);
+			lastSums[candidates] = prefix.sum + last;
+		}
+		validate_card_batch(lastMasks, lastSums, candidates, lastValid);
+
+		for (int last = low; last <= high; last++) {
+			long long cards = binomial(_drawRange - last, Game::BonusNumbers); // One card per choice of bonus numbers.
+			generated += cards;
+			if (!lastValid[last - low])
+				continue;
+			valid += cards;
+			for_each_lex_set<Game::BonusNumbers>(last + 1, _drawRange, prefix.with(last), extend, writeCard);
+		}
+	};
+
+	CardPrefix start = {};
+	start = start.with(first).with(second);
+	for_each_lex_set<_drawMainNumbers - 3>(second + 1, _drawRange - Game::BonusNumbers - 1, start, extend, expand);
+	return generated;
+}
+
+void Analyse::create_all_combinations()
+{
+	//This function creates every draw combination and validates them for use in this program.
+	// Each block of cards sharing the same two leading numbers is generated by a worker into its own buffer.
+	// The calling thread writes the finished buffers to the file strictly in block order, so the output
+	// is byte-for-byte what the sequential nested loops produced. Workers may only run a limited number of
+	// blocks ahead of the writer, which keeps memory bounded while the file is written.
+
+	PROFILE_SCOPE(Combinations);
+	FILE *CombinationOutputFile = fopen(_combinationCollectionFile, "wb");
+	if (!CombinationOutputFile) {
+		*_report << "[Error] Failed to open combination file for writing: " << _combinationCollectionFile << endl;
+		return;
+	}
+
+	struct CombinationBlock {
+		int first;
+		int second;
+		std::string text;
+		long long generated = 0;
+		long long valid = 0;
+		bool done = false;
+	};
+	std::vector<CombinationBlock> blocks;
+	for (int first = 1; first <= _drawRange - _drawCardSize + 1; first++)
+		for (int second = first + 1; second <= _drawRange - _drawCardSize + 2; second++)
+			blocks.push_back({first, second, {}});
+	const double totalCards = static_cast<double>(binomial(_drawRange, _drawCardSize));
+
+	ThreadPool pool(static_cast<unsigned>(_workerThreads));
+	const size_t window = 4 * pool.size();   // How many blocks may be finished but not yet written.
+	std::mutex blockLock;
+	std::condition_variable blockDone;
+	std::condition_variable blockWritten;
+	size_t nextBlock = 0;                     // Next block a worker may claim.
+	size_t writtenBlocks = 0;                 // Blocks already written to the file.
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned worker = 0; worker < pool.size(); worker++) {
+		pool.submit([&]() {
+			for (;;) {
+				size_t index;
+				{
+					std::unique_lock<std::mutex> guard(blockLock);
+					blockWritten.wait(guard, [&]() { return nextBlock >= blocks.size() || nextBlock < writtenBlocks + window; });
+					if (nextBlock >= blocks.size()) return;
+					index = nextBlock++;
+				}
+				CombinationBlock& block = blocks[index];
+				block.generated = generate_combination_block(block.first, block.second, block.text, block.valid);
+				PROFILE_ALLOCATED(Combinations, block.text.capacity());
+				{
+					std::lock_guard<std::mutex> guard(blockLock);
+					block.done = true;
+				}
+				blockDone.notify_all();
+			}
+		});
+	}
+
+	long long TotalGeneratedCombinations = 0;
+	long long TotalValidCombinations = 0;
+	int lastReported = 0;
+	for (size_t index = 0; index < blocks.size(); index++) {
+		CombinationBlock& block = blocks[index];
+		{
+			std::unique_lock<std::mutex> guard(blockLock);
+			blockDone.wait(guard, [&]() { return block.done; });
+		}
+		fwrite(block.text.data(), 1, block.text.size(), CombinationOutputFile);
+		TotalGeneratedCombinations += block.generated;
+		TotalValidCombinations += block.valid;
+		std::string().swap(block.text); // Release the buffer as soon as it is written.
+		{
+			std::lock_guard<std::mutex> guard(blockLock);
+			writtenBlocks = index + 1;
+		}
+		blockWritten.notify_all();
+
+		// Report progress every 10% of the combination space.
+		int percent = static_cast<int>(100.0 * TotalGeneratedCombinations / totalCards);
+		if (percent / 10 > lastReported / 10) {
+			lastReported = percent;
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			*_report << "[Info] Combinations: " << percent << "% (" << TotalGeneratedCombinations << " cards, "
+			     << static_cast<long long>(TotalGeneratedCombinations / std::max(seconds, 1e-9)) << " cards/sec)" << '\n';
+		}
+	}
+	pool.wait();
+	fclose(CombinationOutputFile);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	_totalValidCombinationCards = static_cast<int>(TotalValidCombinations);
+    *_report << "Generated " << TotalGeneratedCombinations << ":" << '\n';
+	*_report << "[Info] " << TotalValidCombinations << " valid cards written in " << seconds << " s ("
+	     << static_cast<long long>(TotalGeneratedCombinations / std::max(seconds, 1e-9)) << " cards/sec on "
+	     << pool.size() << " threads)" << '\n';
+}
+
+bool Analyse::create_combination_index(const char *path, bool withRankList)
+{
+	/* Function to build the binary combination index.
+	The main numbers of a card are its lowest numbers and the bonus numbers sit above them. In colex order
+	the bonus numbers change slowest, and for a fixed set of bonus numbers the cards are every set of main
+	numbers below the lowest bonus number, in colex order of those main numbers. Only the main numbers are
+	validated, so the validity of all cards is the validity of the main-number sets (for Lotto 649, the
+	C(48,6) = 12.3M six-number sets of 1..48), repeated once per bonus set over a growing prefix. That table
+	is validated in batches and then copied into the full bitset (for Lotto 649, C(49,7) = 85.9M bits, about 11 MB).*/
+
+	uint64_t setCount = static_cast<uint64_t>(binomial(_drawRange - Game::BonusNumbers, _drawMainNumbers));
+	std::vector<uint8_t> setValid(setCount);
+
+	// Enumerate the main-number sets in colex order: the upper numbers in colex order, the lowest number fastest.
+	struct UpperSet { CardMask mask; int sum; int lowest; };
+	uint64_t setRank = 0;
+	CardMask masks[_drawRange];
+	int sums[_drawRange];
+	auto extendUpper = [](const UpperSet& set, int number, int) { return UpperSet{set.mask | (1ULL << number), set.sum + number, number}; };
+	auto validateLowest = [&](const UpperSet& upper) {
+		int candidates = 0;
+		for (int lowest = 1; lowest < upper.lowest; lowest++, candidates++) {
+			masks[candidates] = upper.mask | (1ULL << lowest);
+			sums[candidates] = upper.sum + lowest;
+		}
+		validate_card_batch(masks, sums, candidates, &setValid[setRank]);
+		setRank += candidates;
+	};
+	for_each_colex_set<_drawMainNumbers - 1>(_drawRange - Game::BonusNumbers + 1, UpperSet{0, 0, 0}, extendUpper, validateLowest);
+
+	// Lay the main-number table out once per set of bonus numbers.
+	CombinationIndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "RACOMBIX", 8);
+	header.formatVersion = 1;
+	header.filterVersion = _combinationFilterVersion;
+	header.drawRange = _drawRange;
+	header.cardSize = _drawCardSize;
+	header.totalCards = static_cast<uint64_t>(binomial(_drawRange, _drawCardSize));
+	std::vector<uint64_t> bits((header.totalCards + 63) / 64, 0);
+	struct BonusSet { uint64_t base; int lowest; };
+	auto extendBonus = [](const BonusSet& set, int number, int position) {
+		return BonusSet{set.base + static_cast<uint64_t>(binomial(number - 1, _drawMainNumbers + position)), number};
+	};
+	auto tileMainSets = [&](const BonusSet& bonus) {
+		// The cards with these bonus numbers are every main-number set below the lowest of them.
+		uint64_t count = static_cast<uint64_t>(binomial(bonus.lowest - 1, _drawMainNumbers));
+		for (uint64_t i = 0; i < count; i++) {
+			if (setValid[i]) {
+				uint64_t rank = bonus.base + i;
+				bits[rank >> 6] |= 1ULL << (rank & 63);
+			}
+		}
+	};
+	for_each_colex_set<Game::BonusNumbers>(_drawRange + 1, BonusSet{0, _drawRange + 1}, extendBonus, tileMainSets);
+	for (uint64_t word : bits)
+		header.validCards += popcount64(word);
+
+	header.bitsetOffset = (sizeof(CombinationIndexHeader) + 63) / 64 * 64;
+	header.rankListOffset = withRankList ? header.bitsetOffset + bits.size() * 8 : 0;
+
+	FILE *indexFile = fopen(path, "wb");
+	if (!indexFile) {
+		*_report << "[Error] Failed to open combination index for writing: " << path << endl;
+		return false;
+	}
+	std::vector<char> padding(header.bitsetOffset - sizeof(header), 0);
+	bool written = fwrite(&header, sizeof(header), 1, indexFile) == 1
+	            && fwrite(padding.data(), 1, padding.size(), indexFile) == padding.size()
+	            && fwrite(bits.data(), 8, bits.size(), indexFile) == bits.size();
+	if (written && withRankList) {
+		// The packed list is written in chunks so it never needs to be held in memory whole.
+		std::vector<uint32_t> ranks;
+		ranks.reserve(1 << 16);
+		for (uint64_t word = 0; word < bits.size() && written; word++) {
+			for (uint64_t remaining = bits[word]; remaining; remaining &= remaining - 1)
+				ranks.push_back(static_cast<uint32_t>(word * 64 + lowest_bit64(remaining)));
+			if (ranks.size() >= (1 << 16) - 64 || word + 1 == bits.size()) {
+				written = fwrite(ranks.data(), 4, ranks.size(), indexFile) == ranks.size();
+				ranks.clear();
+			}
+		}
+	}
+	if (fclose(indexFile) != 0 || !written) {
+		*_report << "[Error] Failed to write combination index: " << path << endl;
+		return false;
+	}
+	*_report << "[Info] Combination index written: " << header.validCards << " valid of " << header.totalCards << " cards." << endl;
+	return true;
+}
+
+bool Analyse::load_combination_index()
+{
+	// Attach the combination index, or build it from the validation rules when it is missing or stale.
+	if (!_combinationIndex.attach(_combinationIndexFile)) {
+		if (_debugMode)
+			*_report << "Combination index missing or out of date, building: " << _combinationIndexFile << endl;
+		if (!create_combination_index(_combinationIndexFile, _combinationRankList)
+		    || !_combinationIndex.attach(_combinationIndexFile)) {
+			*_report << "[Error] Could not load the combination index: " << _combinationIndexFile << endl;
+			return false;
+		}
+	}
+	_totalValidCombinationCards = static_cast<int>(_combinationIndex.valid_cards());
+	return true;
+}
+
+void Analyse::card_score_weights(CardScoreMetric metric, double *weights)
+{
+	weights[0] = 0.0;
+	for (int ball = 0; ball < _drawRange; ball++)
+		weights[ball + 1] = metric == CardScoreMetric::Average ? _drawStats.average[ball] : _drawStats.ordinalChance[ball];
+}
+
+template <class Combine>
+long long Analyse::score_combination_block(int top, int second, const double *weights, Combine combine,
+                                           BoundedCardHeap<HigherCardScore>& best, BoundedCardHeap<LowerCardScore>& worst)
+{
+	// Walks the block in colex order (lowest number fastest), so the rank simply counts up from the block's base.
+	// Partial scores, masks and sums are carried down the loops so the innermost loop adds one number.
+	struct PartialCard { CardMask mask; int sum; double score; };
+	const bool useIndex = _combinationIndex.is_attached();
+	uint64_t rank = static_cast<uint64_t>(binomial(top - 1, _drawCardSize) + binomial(second - 1, _drawCardSize - 1));
+	long long scored = 0;
+
+	// Only the main numbers (the lowest slots of the card) go into the validation mask and sum.
+	auto extend = [&](const PartialCard& card, int number, int position) {
+		PartialCard next = {card.mask, card.sum, combine(card.score, weights[number])};
+		if (position <= _drawMainNumbers) {
+			next.mask |= 1ULL << number;
+			next.sum += number;
+		}
+		return next;
+	};
+	auto visit = [&](const PartialCard& card) {
+		bool valid = useIndex ? _combinationIndex.is_valid_rank(rank) : validate_card_mask(card.mask, card.sum);
+		if (valid) {
+			scored++;
+			if (best.admits(card.score, rank)) best.push(ScoredCard{card.score, rank, {}});
+			if (worst.admits(card.score, rank)) worst.push(ScoredCard{card.score, rank, {}});
+		}
+		rank++;
+	};
+
+	// The two highest numbers are fixed for the block.
+	PartialCard start = {0, 0, combine(weights[top], weights[second])};
+	if (_drawCardSize <= _drawMainNumbers) {
+		start.mask |= 1ULL << top;
+		start.sum += top;
+	}
+	if (_drawCardSize - 1 <= _drawMainNumbers) {
+		start.mask |= 1ULL << second;
+		start.sum += second;
+	}
+	for_each_colex_set<_drawCardSize - 2>(second, start, extend, visit);
+	return scored;
+}
+
+CardScoreReport Analyse::score_all_combinations(const double *weights, CardScoreCombine combine, int count)
+{
+	/* Function to score every valid combination and keep the best and worst 'count' cards.
+	The combination space is split into blocks by the two highest numbers of a card (about a thousand
+	blocks), which the workers claim one at a time, largest first. Every worker keeps its own bounded
+	best and worst heaps, so nothing is shared while scoring; the heaps are merged once at the end.*/
+
+	PROFILE_SCOPE(Scoring);
+	CardScoreReport report;
+	size_t capacity = static_cast<size_t>(std::max(0, count));
+
+	std::vector<std::pair<int, int>> blocks;
+	for (int top = _drawRange; top >= _drawCardSize; top--)
+		for (int second = top - 1; second >= _drawCardSize - 1; second--)
+			blocks.push_back({top, second});
+
+	ThreadPool pool(static_cast<unsigned>(_workerThreads));
+	std::vector<BoundedCardHeap<HigherCardScore>> bestHeaps(pool.size(), BoundedCardHeap<HigherCardScore>(capacity));
+	std::vector<BoundedCardHeap<LowerCardScore>> worstHeaps(pool.size(), BoundedCardHeap<LowerCardScore>(capacity));
+	std::vector<long long> scored(pool.size(), 0);
+	std::atomic<size_t> nextBlock(0);
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned worker = 0; worker < pool.size(); worker++) {
+		pool.submit([&, worker]() {
+			for (size_t index; (index = nextBlock++) < blocks.size(); ) {
+				int top = blocks[index].first;
+				int second = blocks[index].second;
+				if (combine == CardScoreCombine::Product)
+					scored[worker] += score_combination_block(top, second, weights, [](double a, double b) { return a * b; },
+					                                          bestHeaps[worker], worstHeaps[worker]);
+				else
+					scored[worker] += score_combination_block(top, second, weights, [](double a, double b) { return a + b; },
+					                                          bestHeaps[worker], worstHeaps[worker]);
+			}
+		});
+	}
+	pool.wait();
+
+	// Merge the per-worker heaps; the total order on (score, rank) makes the result independent of the split.
+	BoundedCardHeap<HigherCardScore> best(capacity);
+	BoundedCardHeap<LowerCardScore> worst(capacity);
+	for (unsigned worker = 0; worker < pool.size(); worker++) {
+		for (const ScoredCard& card : bestHeaps[worker].sorted()) best.push(card);
+		for (const ScoredCard& card : worstHeaps[worker].sorted()) worst.push(card);
+		report.scoredCards += scored[worker];
+	}
+	report.best = best.sorted();
+	report.worst = worst.sorted();
+	for (ScoredCard& card : report.best) _combinationIndex.card_at(card.rank, card.balls);
+	for (ScoredCard& card : report.worst) _combinationIndex.card_at(card.rank, card.balls);
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
+
+void Analyse::copy_replay_parameters(Analyse& replica) const
+{
+	replica._drawSampleSize = _drawSampleSize;
+	replica._ordinalSampleSize = _ordinalSampleSize;
+	replica._ordinalGrowth = _ordinalGrowth;
+	replica._recency = _recency;
+}
+
+void Analyse::copy_analysis_state(const Analyse& source)
+{
+	_lastDraw = source._lastDraw;
+	_totalEvents = source._totalEvents;
+	_processedDraws = source._processedDraws;
+	_seeded = source._seeded;
+	_drawStats = source._drawStats;
+	_coOccurrence = source._coOccurrence;
+	_totalValidCombinationCards = source._totalValidCombinationCards;
+	_retiredLevels = source._retiredLevels;
+	// A bounded tree relies on its arena being reserved up front; the copy keeps the same capacity.
+	_ordinalTree.reserve(source._ordinalTree.capacity());
+	_ordinalTree = source._ordinalTree;
+	_ordinalRecency.reserve(source._ordinalRecency.capacity());
+	_ordinalRecency = source._ordinalRecency;
+	_drawRecency = source._drawRecency;
+	_drawHistoryTotal = source._drawHistoryTotal;
+	_ordinalBranchTotalNodes = source._ordinalBranchTotalNodes;
+}
+
+BacktestSplit Analyse::score_backtest_split(const std::vector<DrawRecord>& history, int split, int horizon, int topN)
+{
+	// Rank the balls best first under each metric; ties go to the lower ball.
+	const double *scores[2] = {_drawStats.ordinalChance, _drawStats.average};
+	int rankOf[2][_drawRange];
+	double probability[2][_drawRange];
+	for (int metric = 0; metric < 2; metric++) {
+		int order[_drawRange];
+		double total = 0.0;
+		for (int ball = 0; ball < _drawRange; ball++) {
+			order[ball] = ball;
+			total += scores[metric][ball];
+		}
+		std::stable_sort(order, order + _drawRange, [&](int a, int b) { return scores[metric][a] > scores[metric][b]; });
+		for (int rank = 0; rank < _drawRange; rank++)
+			rankOf[metric][order[rank]] = rank;
+
+		// The chance of each ball being drawn: its share of the total score, scaled to the balls in a draw.
+		for (int ball = 0; ball < _drawRange; ball++) {
+			double chance = total > 0.0 ? _drawCardSize * scores[metric][ball] / total : static_cast<double>(_drawCardSize) / _drawRange;
+			probability[metric][ball] = std::min(std::max(chance, 1e-6), 1.0 - 1e-6);
+		}
+	}
+
+	BacktestSplit result = {split, 0, {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}};
+	int last = std::min(static_cast<int>(history.size()), split + horizon);
+	for (int draw = split; draw < last; draw++) {
+		bool drawn[_drawRange] = {};
+		for (uint8_t ballNumber : history[draw].balls)
+			drawn[ballNumber - 1] = true;
+		for (int metric = 0; metric < 2; metric++) {
+			for (uint8_t ballNumber : history[draw].balls) {
+				int rank = rankOf[metric][ballNumber - 1];
+				result.hits[metric] += rank < topN;
+				result.meanRank[metric] += rank + 1;
+			}
+			double loss = 0.0;
+			for (int ball = 0; ball < _drawRange; ball++)
+				loss -= drawn[ball] ? log(probability[metric][ball]) : log(1.0 - probability[metric][ball]);
+			result.logLoss[metric] += loss / _drawRange;
+		}
+		result.evaluated++;
+	}
+	for (int metric = 0; metric < 2 && result.evaluated; metric++) {
+		result.hits[metric] /= result.evaluated;
+		result.meanRank[metric] /= static_cast<double>(result.evaluated) * _drawCardSize;
+		result.logLoss[metric] /= result.evaluated;
+	}
+	return result;
+}
+
+BacktestReport Analyse::run_backtest(int splits, int horizon, int topN)
+{
+	/* Function to run a walk-forward backtest over the draw array.
+	The split points are spread evenly from the end of the seeding phase to the last draw that still has
+	'horizon' draws after it. Training is a plain replay, so the state at a split is the state after the
+	previous split plus the draws in between: one analyzer instance walks the draw array once, on this
+	thread, and at every split point its state is copied into a fresh instance whose correlation and
+	scoring run on the pool while the walk goes on. At most two copies per worker wait to be scored, which
+	bounds the memory however many splits are asked for.*/
+
+	BacktestReport report;
+	report.topN = topN;
+	report.horizon = horizon;
+	int firstSplit = _drawSampleSize + 1;
+	int lastSplit = static_cast<int>(_drawHistory.size()) - horizon;
+	if (splits <= 0 || horizon <= 0 || lastSplit < firstSplit) {
+		*_report << "[Warning] Not enough draws for a backtest after the " << _drawSampleSize << "-draw seeding phase." << endl;
+		return report;
+	}
+	splits = std::min(splits, lastSplit - firstSplit + 1);
+	std::vector<int> splitPoints(splits);
+	for (int i = 0; i < splits; i++)
+		splitPoints[i] = splits == 1 ? lastSplit : firstSplit + static_cast<int>(static_cast<long long>(lastSplit - firstSplit) * i / (splits - 1));
+	report.splits.resize(splits);
+
+	ThreadPool pool(static_cast<unsigned>(_workerThreads));
+	const std::vector<DrawRecord>& history = _drawHistory;
+	std::vector<std::unique_ptr<Analyse>> copies(splits);
+	std::mutex lock;
+	std::condition_variable scored;
+	unsigned pending = 0; // Copies queued or being scored.
+	auto start = std::chrono::steady_clock::now();
+
+	std::unique_ptr<Analyse> walker(new Analyse());
+	copy_replay_parameters(*walker);
+	walker->init_all();
+	for (int i = 0; i < splits; i++) {
+		while (walker->_processedDraws < splitPoints[i])
+			walker->analyse_draw(history[walker->_processedDraws]);
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			scored.wait(guard, [&]() { return pending < 2 * pool.size(); });
+			pending++;
+		}
+		copies[i].reset(new Analyse());
+		copies[i]->copy_analysis_state(*walker);
+		pool.submit([&, i]() {
+			copies[i]->correlate_data();
+			report.splits[i] = copies[i]->score_backtest_split(history, splitPoints[i], horizon, topN);
+			copies[i].reset();
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				pending--;
+			}
+			scored.notify_one();
+		});
+	}
+	pool.wait();
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
 
-    // Recalculate the average based on the updated totals.
-    // The average is the ratio of total times drawn to the number of opportunities.
-    Number->average = static_cast<double>(Number->totalTimesDrawn) / static_cast<double>(Number->drawOpportunities);
+std::vector<SweepResult> Analyse::run_parameter_sweep(const std::vector<SweepParameters>& grid, int topN)
+{
+	/* Function to evaluate a grid of parameter configurations.
+	Every configuration is an independent job: a private analyzer instance with its own thresholds replays
+	the shared draw array up to its holdout, correlates and scores the holdout. The jobs only read the draw
+	array and each writes its own result slot, so they run without any locking and scale with the cores.*/
+
+	std::vector<SweepResult> results(grid.size());
+	const std::vector<DrawRecord>& history = _drawHistory;
+
+	ThreadPool pool(static_cast<unsigned>(_workerThreads));
+	for (size_t job = 0; job < grid.size(); job++) {
+		pool.submit([&, job]() {
+			auto start = std::chrono::steady_clock::now();
+			const SweepParameters& parameters = grid[job];
+			std::unique_ptr<Analyse> analyser(new Analyse());
+			copy_replay_parameters(*analyser);
+			analyser->_drawSampleSize = parameters.drawSampleSize;
+			analyser->_ordinalSampleSize = parameters.ordinalSampleSize;
+			analyser->_testDrawCount = parameters.testDrawCount;
+			analyser->init_all();
+
+			int trainDraws = std::max(0, static_cast<int>(history.size()) - parameters.testDrawCount);
+			for (int draw = 0; draw < trainDraws; draw++)
+				analyser->analyse_draw(history[draw]);
+			analyser->correlate_data();
+
+			SweepResult& result = results[job];
+			result.parameters = parameters;
+			result.ordinalLevels = analyser->_ordinalBranchTotalNodes;
+			result.holdout = analyser->score_backtest_split(history, trainDraws, parameters.testDrawCount, topN);
+			result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		});
+	}
+	pool.wait();
+	return results;
+}
 
-    // Record the event number when this number was last drawn.
-    // This value is set to the current total draw events in the system.
-    Number->lastDrawn = _drawHistoryTotal;
+void Analyse::display_parameter_sweep(const std::vector<SweepResult>& results, int topN)
+{
+	// Function to display a parameter sweep as one table, one configuration per row.
+	*_report << "Parameter Sweep (" << results.size() << " configurations, holdout hits in top " << topN
+	          << ", ordinalChance/average):" << std::endl;
+	*_report << "  DrawSample OrdinalSample TestDraws Levels    Hits(OC)   Hits(Avg)   Rank(OC)  Rank(Avg)    Loss(OC)   Loss(Avg)   Seconds" << std::endl;
+	*_report << std::fixed;
+	for (const SweepResult& result : results) {
+		*_report << "  " << setw(10) << result.parameters.drawSampleSize
+		          << ' ' << setw(13) << result.parameters.ordinalSampleSize
+		          << ' ' << setw(9) << result.parameters.testDrawCount
+		          << ' ' << setw(6) << result.ordinalLevels
+		          << setprecision(4)
+		          << ' ' << setw(11) << result.holdout.hits[0] << ' ' << setw(11) << result.holdout.hits[1]
+		          << ' ' << setw(10) << result.holdout.meanRank[0] << ' ' << setw(10) << result.holdout.meanRank[1]
+		          << ' ' << setw(11) << result.holdout.logLoss[0] << ' ' << setw(11) << result.holdout.logLoss[1]
+		          << ' ' << setw(9) << result.seconds << std::endl;
+	}
+	*_report << std::defaultfloat << setprecision(6);
+}
 
-    // Mark the number as drawn in the current draw.
-    Number->isDrawn = true;
+double Analyse::ordinal_level_spread(const OrdinalBranchNode& level)
+{
+	auto range = std::minmax_element(level.average, level.average + _drawRange);
+	return *range.second - *range.first;
+}
 
-/* TODO: Extend this function to include additional statistical calculations in the future.
-Potential future calculations might include:
-- Update sigma (standard deviation) based on the new draw event.
-- Calculate and update any custom metrics that need to be tracked for each draw.
-- Log or record additional metadata related to the draw event, such as draw date or position in the draw.*/
+// Fills the numbers of 'draw' with _drawCardSize distinct numbers drawn uniformly from 'stream'.
+static void uniform_draw(std::mt19937_64& stream, std::uniform_int_distribution<int>& ballDistribution, DrawRecord& draw) {
+	CardMask drawn = 0;
+	for (int slot = 0; slot < _drawCardSize; slot++) {
+		int ball;
+		do ball = ballDistribution(stream); while (drawn & (1ULL << ball));
+		drawn |= 1ULL << ball;
+		draw.balls[slot] = static_cast<uint8_t>(ball);
+	}
 }
 
-DrawSet Analyse::extract_draw_vector(const std::string& line) {
-    DrawSet draw;                   // Initialize an empty DrawSet to store the ball numbers.
-    std::stringstream ss(line);     // Create a stringstream to parse the input line.
-    std::string drawDate;           // Variable to store the draw date (which will be skipped).
-    std::string ballStr;            // Variable to hold each ball number as a string.
-
-    // Attempt to read and skip the draw date, which is the first value in the line.
-    // If the draw date cannot be read, output an error message and return an empty DrawSet.
-    if (!getline(ss, drawDate, ',')) {
-        std::cerr << "[Error] Failed to read draw date from line: " << line << std::endl;
-        return draw; // Return an empty DrawSet if there's an error
-    }
-
-    // Process each ball number in the draw by reading the remaining values in the line.
-    while (getline(ss, ballStr, ',')) {
-        try {
-            int ballNumber = std::stoi(ballStr); // Convert the string representation of the ball number to an integer.
-            draw.push_back(ballNumber);          // Add the ball number directly to the DrawSet.
-        } catch (const std::invalid_argument&) {
-            // If the conversion fails (e.g., the value is not a valid integer), output an error message
-            // and return an empty DrawSet, as this indicates invalid data.
-            std::cerr << "[Error] Invalid ball number in line: " << ballStr << std::endl;
-            return draw; // Return an empty DrawSet if there's an error
-        }
-    }
+NullDistributionReport Analyse::run_null_simulations(long long simulations, uint64_t seed)
+{
+	/* Function to build null distributions for the analyzer's statistics.
+	Each simulated history is a stream of uniform draws of _drawCardSize distinct numbers, generated
+	on the fly from an mt19937_64 seeded by a SplitMix64 hash of (seed, simulation index), and fed
+	straight into the analyzer one draw at a time. A worker keeps one analyzer instance and resets it
+	with init_all between histories: the ordinal tree keeps its capacity, so after the first history
+	the runs do not allocate. Every worker accumulates its own comparisons; they are merged at the end.*/
+
+	NullDistributionReport report;
+	report.historyLength = _processedDraws;
+	for (int ball = 0; ball < _drawRange; ball++) {
+		report.realOrdinalChance[ball] = _drawStats.ordinalChance[ball];
+		report.realAverage[ball] = _drawStats.average[ball];
+	}
+	report.firstLevel = _retiredLevels.levels + 1;
+	report.realLevels = _ordinalBranchTotalNodes;
+	for (const OrdinalBranchNode& level : _ordinalTree)
+		report.realLevelSpread.push_back(ordinal_level_spread(level));
+	report.levelSpread.resize(report.realLevelSpread.size());
+	if (simulations <= 0 || report.historyLength == 0) return report;
+
+	ThreadPool pool(static_cast<unsigned>(_workerThreads));
+	std::vector<NullDistributionReport> partial(pool.size(), report);
+	std::atomic<long long> nextSimulation(0);
+	const long long chunk = 16;   // Simulations claimed at a time.
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned worker = 0; worker < pool.size(); worker++) {
+		pool.submit([&, worker]() {
+			NullDistributionReport& local = partial[worker];
+			std::unique_ptr<Analyse> analyser(new Analyse());
+			copy_replay_parameters(*analyser);
+			std::uniform_int_distribution<int> ballDistribution(1, _drawRange);
+
+			for (long long first; (first = nextSimulation.fetch_add(chunk)) < simulations; ) {
+				for (long long simulation = first; simulation < std::min(first + chunk, simulations); simulation++) {
+					// SplitMix64 of (seed, simulation): independent, reproducible streams.
+					uint64_t state = seed + 0x9e3779b97f4a7c15ULL * static_cast<uint64_t>(simulation + 1);
+					state = (state ^ (state >> 30)) * 0xbf58476d1ce4e5b9ULL;
+					state = (state ^ (state >> 27)) * 0x94d049bb133111ebULL;
+					std::mt19937_64 stream(state ^ (state >> 31));
+
+					analyser->init_all();
+					DrawRecord draw = {};
+					for (int index = 0; index < local.historyLength; index++) {
+						uniform_draw(stream, ballDistribution, draw);
+						analyser->analyse_draw(draw);
+					}
+					analyser->correlate_data();
 
-    return draw; // Return the populated DrawSet.
+					for (int ball = 0; ball < _drawRange; ball++) {
+						local.ordinalChance[ball].add(analyser->_drawStats.ordinalChance[ball], local.realOrdinalChance[ball]);
+						local.average[ball].add(analyser->_drawStats.average[ball], local.realAverage[ball]);
+					}
+					// Levels are matched by their number in the whole tree, since either tree may have retired levels.
+					int offset = analyser->_retiredLevels.levels + 1 - local.firstLevel;
+					for (int level = std::max(0, -offset); level < static_cast<int>(analyser->_ordinalTree.size())
+					                                        && level + offset < static_cast<int>(local.levelSpread.size()); level++)
+						local.levelSpread[level + offset].add(ordinal_level_spread(analyser->_ordinalTree[level]), local.realLevelSpread[level + offset]);
+					local.levels.add(static_cast<double>(analyser->_ordinalBranchTotalNodes), static_cast<double>(local.realLevels));
+				}
+			}
+		});
+	}
+	pool.wait();
+
+	for (const NullDistributionReport& local : partial) {
+		for (int ball = 0; ball < _drawRange; ball++) {
+			report.ordinalChance[ball].merge(local.ordinalChance[ball]);
+			report.average[ball].merge(local.average[ball]);
+		}
+		for (size_t level = 0; level < report.levelSpread.size(); level++)
+			report.levelSpread[level].merge(local.levelSpread[level]);
+		report.levels.merge(local.levels);
+	}
+	report.simulations = report.levels.samples;
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
 }
 
-bool Analyse::validate_draw_combination(Card PossibleCombinationCard)
+void Analyse::display_null_distribution(const NullDistributionReport& report)
 {
-	/*there are a set of statistical annomolies that relate to winning draws, 
-	this function will invalidate any combination without these traits.
-	It must have a Prime Number, an even and odd number, properly ranged in value,
-	the sum is between a certain range.*/ 
-	int Even = 0;
-	int Summation = 0;
-	int Ones = 0;
-	int Tens = 0;
-	int Twenties = 0;
-	int Thirties = 0;
-	int forties = 0;
-	int Low = 0;
-	//check for a prime number, invalid if not
-	if (!prime_number_check(PossibleCombinationCard))
-		return false;
-	
-    // there is a much better way im sure with some effort.
-	for (int i = 0; i < 6; i++)
-	{
-		if (PossibleCombinationCard[i] % 2 == 0)
-			Even++;
-		Summation = Summation + PossibleCombinationCard[i];
-		if (PossibleCombinationCard[i] < 10)
-			Ones++;
-		else if (PossibleCombinationCard[i] < 20)
-			Tens++;
-		else if (PossibleCombinationCard[i] < 30)
-			Twenties++;
-		else if (PossibleCombinationCard[i] < 40)
-			Thirties++;
-		else if (PossibleCombinationCard[i] < 50)
-			forties++;
-		if (PossibleCombinationCard[i] < 25)
-			Low++;
+	// Function to display the real statistics next to their null distributions (mean, deviation, percentile).
+	if (report.simulations == 0) return;
+	*_report << "Null Distribution (" << report.simulations << " uniform histories of " << report.historyLength << " draws):" << std::endl;
+	int extreme = 0;   // Balls whose ordinalChance is outside the central 95% of its null distribution.
+	for (int ball = 0; ball < _drawRange; ball++) {
+		const NullStatistic& chance = report.ordinalChance[ball];
+		const NullStatistic& average = report.average[ball];
+		extreme += chance.percentile() < 2.5 || chance.percentile() > 97.5;
+		*_report << "  Draw Number: " << ball + 1
+		          << " Ordinal Chance: " << report.realOrdinalChance[ball] << " (null " << chance.mean() << " +/- " << chance.deviation()
+		          << ", percentile " << chance.percentile() << ")"
+		          << " Average: " << report.realAverage[ball] << " (null " << average.mean() << " +/- " << average.deviation()
+		          << ", percentile " << average.percentile() << ")" << std::endl;
 	}
-	if (Even < 2 || Even > 4)
-		return false;
-	if (Summation < 121 || Summation > 200)
-		return false;
-	if (Low < 2 || Low > 4)
-		return false;
-	if (Ones > 3 || Tens > 3 || Twenties > 3 || Thirties > 3 || forties > 3)
-		return false;
-	if (Ones && Tens && Twenties && Thirties && forties)
-		return false;
-	return true;
+	for (size_t level = 0; level < report.levelSpread.size(); level++) {
+		const NullStatistic& spread = report.levelSpread[level];
+		*_report << "  Ordinal Level " << report.firstLevel + level << " spread: " << report.realLevelSpread[level]
+		          << " (null " << spread.mean() << " +/- " << spread.deviation() << " over " << spread.samples
+		          << " histories, percentile " << spread.percentile() << ")" << std::endl;
+	}
+	*_report << "  Ordinal levels: " << report.realLevels << " (null " << report.levels.mean() << " +/- "
+	          << report.levels.deviation() << ", percentile " << report.levels.percentile() << ")" << std::endl;
+	*_report << "  " << extreme << " of " << _drawRange << " balls have an ordinalChance outside the central 95% (about "
+	          << 0.05 * _drawRange << " expected by chance)." << std::endl;
+	*_report << "[Info] Simulated " << report.simulations << " histories in " << report.seconds << " s ("
+	          << report.simulations / std::max(report.seconds, 1e-9) << " histories/sec)" << std::endl;
 }
-bool Analyse::prime_number_check(Card num)
+
+void Analyse::display_backtest(const BacktestReport& report)
 {
-	for (int i = 0; i < 6; i++)
-	{
-		for (int j = 0; j < 15; j++)
-		{
-			if (num[i] == _primeNumbers[j])
-				return true;
+	// Function to display a walk-forward backtest: one line per split, then the averages next to chance.
+	const char *metricName[2] = {"Ordinal Chance", "Average"};
+	double hits[2] = {}, meanRank[2] = {}, logLoss[2] = {};
+	for (const BacktestSplit& split : report.splits) {
+		if (_debugMode)
+			*_report << "  Split: " << split.split << " Draws: " << split.evaluated
+			          << " Hits: " << split.hits[0] << '/' << split.hits[1]
+			          << " Mean Rank: " << split.meanRank[0] << '/' << split.meanRank[1]
+			          << " Log Loss: " << split.logLoss[0] << '/' << split.logLoss[1] << std::endl;
+		for (int metric = 0; metric < 2; metric++) {
+			hits[metric] += split.hits[metric];
+			meanRank[metric] += split.meanRank[metric];
+			logLoss[metric] += split.logLoss[metric];
 		}
 	}
-	return false;
+	if (report.splits.empty()) return;
+
+	double splits = static_cast<double>(report.splits.size());
+	double chance = static_cast<double>(_drawCardSize) / _drawRange;
+	*_report << "Backtest (" << report.splits.size() << " splits, " << report.horizon << " draw(s) each, top "
+	          << report.topN << "):" << std::endl;
+	for (int metric = 0; metric < 2; metric++)
+		*_report << "  Ranked by " << metricName[metric] << ": Hits in top " << report.topN << ": " << hits[metric] / splits
+		          << " Mean Rank: " << meanRank[metric] / splits << " Log Loss: " << logLoss[metric] / splits << std::endl;
+	*_report << "  Chance: Hits in top " << report.topN << ": " << _drawCardSize * static_cast<double>(report.topN) / _drawRange
+	          << " Mean Rank: " << (_drawRange + 1) / 2.0
+	          << " Log Loss: " << -(chance * log(chance) + (1.0 - chance) * log(1.0 - chance)) << std::endl;
+	*_report << "[Info] Backtest finished in " << report.seconds << " s" << std::endl;
 }
 
-void Analyse::create_all_combinations()
+void Analyse::display_co_occurrence(int count)
 {
-	//This function creates every draw combination and validates them for use in this program.
+	// Function to display the most frequent pairs and triples. Under uniform draws every pair is held by
+	// k(k-1) / (n(n-1)) of the draws and every triple by k(k-1)(k-2) / (n(n-1)(n-2)), for k numbers drawn out of n.
+	const double k = _drawCardSize, n = _drawRange;
+	auto display = [this](const char *title, double expected, const std::vector<GroupStatistic>& groups) {
+		*_report << title << " (uniform average " << expected << "):" << std::endl;
+		for (const GroupStatistic& group : groups) {
+			*_report << "  Numbers:";
+			for (int i = 0; i < group.size; i++)
+				*_report << ' ' << group.balls[i];
+			*_report << " Drawn: " << group.drawn << " Average: " << group.average << std::endl;
+		}
+	};
+	*_report << "Pair and Triple Co-occurrence (" << _coOccurrence.draws << " draws):" << std::endl;
+	display("Top Pairs", k * (k - 1) / (n * (n - 1)), top_pairs(count));
+	display("Top Triples", k * (k - 1) * (k - 2) / (n * (n - 1) * (n - 2)), top_triples(count));
+}
 
-	FILE *CombinationOutputFile = fopen(_combinationCollectionFile, "wb");
-	int TotalGeneratedCombinations = 0;
-    int TotalValidCombinations = 0;
-	Card DrawCombination;
-    string combinationLine;
-	for (int t = 0; t < _drawCardSize; t++)
-		DrawCombination[t] = 0;
-	for (int DrawPosition1 = 1; DrawPosition1 <= 43; DrawPosition1++)
-	{
-		for (int DrawPosition2 = DrawPosition1 + 1; DrawPosition2 <= 44; DrawPosition2++)
-		{
-			for (int DrawPosition3 = DrawPosition2 + 1; DrawPosition3 <= 45; DrawPosition3++)
-			{
-				for (int DrawPosition4 = DrawPosition3 + 1; DrawPosition4 <= 46; DrawPosition4++)
-				{
-					for (int DrawPosition5 = DrawPosition4 + 1; DrawPosition5 <= 47; DrawPosition5++)
-					{
-						for (int DrawPosition6 = DrawPosition5 + 1; DrawPosition6 <= 48; DrawPosition6++)
-						{
-                            for (int DrawPosition7 = DrawPosition6 +1; DrawPosition7 <= 49; DrawPosition7++)
-                            {
-                                DrawCombination[0] = DrawPosition1;
-                                DrawCombination[1] = DrawPosition2;
-                                DrawCombination[2] = DrawPosition3;
-                                DrawCombination[3] = DrawPosition4;
-                                DrawCombination[4] = DrawPosition5;
-                                DrawCombination[5] = DrawPosition6;
-                                DrawCombination[6] = DrawPosition7;
-                                TotalGeneratedCombinations++;
-                                if (validate_draw_combination(DrawCombination)) {
-                                    TotalValidCombinations++;
-
-									combinationLine.clear();
-                                    for (int j = 0; j < _drawCardSize; ++j) {
-                                        combinationLine += to_string(DrawCombination[j]) + ' ';
-                                    }
-                                    combinationLine.pop_back(); // Remove the trailing space
-                                    combinationLine += '\n';
-                                     // Write the entire line to the file
-                                    fprintf(CombinationOutputFile, "%s", combinationLine.c_str());
-                                }
-                            }
-                        }
-					}
-				}
-			}
+void Analyse::display_card_scores(const CardScoreReport& report)
+{
+	// Function to display the best and worst cards of a scoring run.
+	auto display = [this](const char *title, const std::vector<ScoredCard>& cards) {
+		*_report << title << std::endl;
+		for (const ScoredCard& card : cards) {
+			*_report << "  Card:";
+			for (int ball : card.balls)
+				*_report << ' ' << ball;
+			CardGroupScore groups = card_group_score(card.balls, _drawCardSize);
+			*_report << " Score: " << card.score << " Pairs: " << groups.pairs << " Triples: " << groups.triples << std::endl;
 		}
-	}
-    cerr << "Generated " << TotalGeneratedCombinations << ":" << '\n';
-	fclose(CombinationOutputFile);
+	};
+	display("Best Cards:", report.best);
+	display("Worst Cards:", report.worst);
+	*_report << "[Info] Scored " << report.scoredCards << " valid cards in " << report.seconds << " s" << std::endl;
 }
 
-ifstream Analyse::collect_census() {
+bool Analyse::load_draw_history() {
+/* Function to decode the draw history file into the draw array in one pass.
+The file is memory mapped and walked line by line in place: no line is copied, numbers are read
+with from_chars, and the date is checked by hand, so the only allocation is the draw array itself.*/
 
-    // Open the draw history file and check for errors
-    ifstream file(_drawHistoryFile);
-    if (!file.is_open()) {
-        cout << "[Error] Failed to open file: " << _drawHistoryFile << endl;
-        return file;
+    MappedFile file;
+    if (!file.open(_drawHistoryFile)) {
+        *_report << "[Error] Failed to open file: " << _drawHistoryFile << endl;
+        return false;
     }
 
-    string line;                    // String to hold each line read from the file
-    int totalDraws = 0;             // Counter for the total number of valid draws processed
-    int expectedNumbersPerDraw = _drawCardSize;  // Expected number of ball numbers per draw
-    int minNumber = 1;              // Minimum valid number for a ball in the draw
-    int maxNumber = _drawRange;     // Maximum valid number for a ball in the draw (using _drawRange)
+    PROFILE_SCOPE(Ingest);
+    _drawHistory.clear();
+    PROFILE_ONLY(size_t capacity = _drawHistory.capacity());
+    _drawHistory.reserve(file.size() / 24 + 1); // A row is at least "YYYY-MM-DD,1,2,3,4,5,6,7" long.
+    PROFILE_GROWTH(DrawHistory, _drawHistory, capacity);
 
-    // Regex to validate date format YYYY-MM-DD
-    regex datePattern(R"(\d{4}-\d{2}-\d{2})");
+    // When the file is being followed, a last line without a newline may still be being written.
+    _historyBytesRead = decode_draw_rows(file.data(), file.data() + file.size(), true, _watchHistory);
+    _historyBytesFingerprint = fingerprint_history(file.data(), _historyBytesRead);
+    _historyFileIdentity = file.identity();
 
-    // Skip the header line of the CSV file if present
-    if (getline(file, line)) {
-        // Header line skipped
-    }
+    // Store the total count of valid draws for further processing
+    _drawHistoryTotal = static_cast<int>(_drawHistory.size());
+    *_report << "[Info] Total valid draws found: " << _drawHistoryTotal << endl;
+    return true;
+}
 
-    // Process each line (draw) in the file
-    while (getline(file, line)) {
-        if (line.empty()) {
-            cout << "[Warning] Skipping empty line in file." << endl;
-            continue;
+size_t Analyse::decode_draw_rows(const char *begin, const char *end, bool atFileStart, bool completeLinesOnly) {
+    const char *cursor = begin;
+    bool header = atFileStart;      // The first line of the CSV file is the header.
+    PROFILE_ONLY(size_t capacity = _drawHistory.capacity());
+
+    // Process each line (draw) in the range
+    while (cursor < end) {
+        const char *lineEnd = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+        if (!lineEnd) {
+            if (completeLinesOnly) break;
+            lineEnd = end;
         }
+        const char *rowEnd = (lineEnd > cursor && lineEnd[-1] == '\r') ? lineEnd - 1 : lineEnd;
+        const char *row = cursor;
+        cursor = std::min(lineEnd + 1, end);
 
-        stringstream ss(line);
-        string drawDate;
-        int ballNumber;
-        int numberCount = 0;
-
-        // Read the draw date
-        if (!getline(ss, drawDate, ',')) {
-            cout << "[Error] Failed to read draw date from line: " << line << endl;
+        // Skip the header line of the CSV file
+        if (header) {
+            header = false;
             continue;
         }
-
-        // Validate the date format using the regex pattern
-        if (!regex_match(drawDate, datePattern)) {
-            cout << "[Error] Invalid date format: " << drawDate << endl;
+        if (row == rowEnd) {
+            *_report << "[Warning] Skipping empty line in file." << endl;
             continue;
         }
 
-        // Validate each ball number in the draw
-        while (getline(ss, line, ',')) {
-            try {
-                ballNumber = stoi(line); // Convert the string to an integer
-            } catch (const invalid_argument&) {
-                cout << "[Error] Invalid ball number in line: " << line << endl;
-                break;
-            }
+        DrawRecord draw;
+        if (parse_draw_row(row, rowEnd, draw))
+            _drawHistory.push_back(draw);
+    }
+    PROFILE_GROWTH(DrawHistory, _drawHistory, capacity);
+    return static_cast<size_t>(cursor - begin);
+}
 
-            // Check if the ball number is within the valid range
-            if (ballNumber < minNumber || ballNumber > maxNumber) {
-                cout << "[Error] Ball number out of range (" << minNumber << "-" << maxNumber << "): " << ballNumber << endl;
-                break;
-            }
+bool Analyse::parse_draw_row(const char *begin, const char *end, DrawRecord& draw) {
+    const char *field = begin;
+    int numberCount = 0;            // Number of ball numbers found in the row.
+
+    // Read the draw date and validate the YYYY-MM-DD format
+    const char *dateEnd = static_cast<const char *>(memchr(begin, ',', end - begin));
+    if (!dateEnd) dateEnd = end;
+    bool dateValid = (dateEnd - begin == 10) && begin[4] == '-' && begin[7] == '-';
+    uint32_t date = 0;
+    for (int i = 0; dateValid && i < 10; i++) {
+        if (i == 4 || i == 7) continue;
+        if (begin[i] < '0' || begin[i] > '9')
+            dateValid = false;
+        else
+            date = date * 10 + static_cast<uint32_t>(begin[i] - '0');
+    }
+    if (!dateValid) {
+        *_report << "[Error] Invalid date format: " << string(begin, dateEnd) << endl;
+        return false;
+    }
+    draw.date = date;
 
-            numberCount++;
+    // Validate each ball number in the draw
+    for (field = dateEnd; field < end; ) {
+        field++; // Step over the comma.
+        while (field < end && (*field == ' ' || *field == '\t')) field++;
+
+        int ballNumber;
+        auto parsed = std::from_chars(field, end, ballNumber);
+        const char *next = parsed.ptr;
+        while (next < end && (*next == ' ' || *next == '\t')) next++;
+        if (parsed.ec != std::errc() || (next < end && *next != ',')) {
+            const char *fieldEnd = static_cast<const char *>(memchr(field, ',', end - field));
+            *_report << "[Error] Invalid ball number in line: " << string(field, fieldEnd ? fieldEnd : end) << endl;
+            return false;
         }
 
-        // Validate that the correct number of balls are present in the draw
-        if (numberCount != expectedNumbersPerDraw) {
-            cout << "[Error] Incorrect number of balls in draw for date: " << drawDate << " - Expected " << expectedNumbersPerDraw << " but found " << numberCount << endl;
-            continue;
+        // Check if the ball number is within the valid range
+        if (ballNumber < 1 || ballNumber > _drawRange) {
+            *_report << "[Error] Ball number out of range (1-" << _drawRange << "): " << ballNumber << endl;
+            return false;
         }
 
-        totalDraws++; // Increment the counter for total valid draws
+        if (numberCount < _drawCardSize)
+            draw.balls[numberCount] = static_cast<uint8_t>(ballNumber);
+        numberCount++;
+        field = next;
     }
 
-    // Store the total count of valid draws for further processing
-    _drawHistoryTotal = totalDraws;
-    cout << "[Info] Total valid draws found: " << totalDraws << endl;
+    // Validate that the correct number of balls are present in the draw
+    if (numberCount != _drawCardSize) {
+        *_report << "[Error] Incorrect number of balls in draw for date: " << string(begin, dateEnd) << " - Expected " << _drawCardSize << " but found " << numberCount << endl;
+        return false;
+    }
+    return true;
+}
 
-    // Clear any EOF flags and rewind the file for further processing
-    file.clear();
-    file.seekg(0);
-    return file; // Return the file handle for further processing
+// Parses a comma separated list of positive integers (for example "100,250,500").
+static std::vector<int> parse_int_list(const string& value) {
+    std::vector<int> values;
+    const char *cursor = value.data();
+    const char *end = cursor + value.size();
+    while (cursor < end) {
+        int number = 0;
+        auto parsed = std::from_chars(cursor, end, number);
+        if (parsed.ec == std::errc() && number > 0)
+            values.push_back(number);
+        const char *comma = static_cast<const char *>(memchr(parsed.ptr, ',', end - parsed.ptr));
+        cursor = comma ? comma + 1 : end;
+    }
+    return values;
 }
 
 bool load_config(const string& configFilePath, Config& config) {
@@ -1257,6 +4620,90 @@ bool load_config(const string& configFilePath, Config& config) {
                 config.drawHistoryFile = value;
             } else if (key == "debugMode") {
                 config.debugMode = (value == "true");
+            } else if (key == "logLevel") {
+                static const char *levelNames[] = {"trace", "debug", "info", "warning", "error"};
+                auto level = std::find(std::begin(levelNames), std::end(levelNames), value);
+                if (level == std::end(levelNames))
+                    cerr << "[Warning] Unknown logLevel '" << value << "'; keeping " << levelNames[static_cast<int>(config.logLevel)] << "." << endl;
+                else
+                    config.logLevel = static_cast<LogLevel>(level - std::begin(levelNames));
+			} else if (key == "combinationIndexFile") {
+                config.combinationIndexFile = value;
+			} else if (key == "combinationRankList") {
+                config.combinationRankList = (value == "true");
+			} else if (key == "snapshotFile") {
+                config.snapshotFile = value;
+			} else if (key == "exportPrefix") {
+                config.exportPrefix = value;
+			} else if (key == "exportFormats") {
+                config.exportFormats = 0;
+                std::stringstream formats(value);
+                string format;
+                while (getline(formats, format, ',')) {
+                    if (format == "csv") config.exportFormats |= ExportCsv;
+                    else if (format == "jsonl") config.exportFormats |= ExportJsonLines;
+                    else if (format == "binary") config.exportFormats |= ExportColumns;
+                    else if (!format.empty()) cerr << "[Warning] Unknown export format '" << format << "' ignored." << endl;
+                }
+			} else if (key == "drawSampleSize") {
+                config.drawSampleSize = std::max(1, atoi(value.c_str()));
+			} else if (key == "ordinalSampleSize") {
+                config.ordinalSampleSize = std::max(1, atoi(value.c_str()));
+			} else if (key == "ordinalMaxLevels") {
+                config.ordinalMaxLevels = std::max(0, atoi(value.c_str()));
+			} else if (key == "ordinalMemoryBudget") {
+                config.ordinalMemoryBudget = std::max(0LL, atoll(value.c_str()));
+			} else if (key == "ordinalRetireSampleSize") {
+                config.ordinalRetireSampleSize = std::max(0, atoi(value.c_str()));
+			} else if (key == "correlateEveryDraw") {
+                config.correlateEveryDraw = (value == "true");
+			} else if (key == "pipelineThreads") {
+                config.pipelineThreads = std::max(0, atoi(value.c_str()));
+			} else if (key == "statisticWindow") {
+                config.statisticWindow = std::max(0, atoi(value.c_str()));
+			} else if (key == "statisticDecay") {
+                double decay = atof(value.c_str());
+                if (decay < 0.0 || decay >= 1.0)
+                    cerr << "[Warning] statisticDecay must be between 0 and 1; keeping " << config.statisticDecay << "." << endl;
+                else
+                    config.statisticDecay = decay;
+			} else if (key == "rankingStatistic") {
+                if (value == "lifetime") config.rankingStatistic = RankingStatistic::Lifetime;
+                else if (value == "window") config.rankingStatistic = RankingStatistic::Window;
+                else if (value == "decayed") config.rankingStatistic = RankingStatistic::Decayed;
+                else cerr << "[Warning] Unknown rankingStatistic '" << value << "' ignored." << endl;
+			} else if (key == "loadTest") {
+                config.loadTest = (value == "true");
+			} else if (key == "testDrawCount") {
+                config.testDrawCount = std::max(1, atoi(value.c_str()));
+			} else if (key == "sweepDrawSampleSizes") {
+                config.sweepDrawSampleSizes = parse_int_list(value);
+			} else if (key == "sweepOrdinalSampleSizes") {
+                config.sweepOrdinalSampleSizes = parse_int_list(value);
+			} else if (key == "sweepTestDrawCounts") {
+                config.sweepTestDrawCounts = parse_int_list(value);
+			} else if (key == "simulations") {
+                config.simulations = std::max(0LL, atoll(value.c_str()));
+			} else if (key == "simulationSeed") {
+                config.simulationSeed = strtoull(value.c_str(), nullptr, 10);
+			} else if (key == "backtestSplits") {
+                config.backtestSplits = std::max(0, atoi(value.c_str()));
+			} else if (key == "backtestHorizon") {
+                config.backtestHorizon = std::max(1, atoi(value.c_str()));
+			} else if (key == "backtestTopN") {
+                config.backtestTopN = std::min(_drawRange, std::max(1, atoi(value.c_str())));
+			} else if (key == "watchHistory") {
+                config.watchHistory = (value == "true");
+			} else if (key == "workerThreads") {
+                config.workerThreads = std::max(0, atoi(value.c_str()));
+			} else if (key == "scoreTopCards") {
+                config.scoreTopCards = std::max(0, atoi(value.c_str()));
+			} else if (key == "coOccurrenceTop") {
+                config.coOccurrenceTop = std::max(0, atoi(value.c_str()));
+			} else if (key == "scoreMetric") {
+                config.scoreMetric = (value == "average") ? CardScoreMetric::Average : CardScoreMetric::OrdinalChance;
+			} else if (key == "scoreCombine") {
+                config.scoreCombine = (value == "product") ? CardScoreCombine::Product : CardScoreCombine::Sum;
 			}
         }
     }
@@ -1264,39 +4711,358 @@ bool load_config(const string& configFilePath, Config& config) {
     return true;
 }
 
-int main() {
-    Config config;
-    string configFilePath = "configs";
+#if defined(RA_BENCHMARK)
+/* Benchmark build.
+Built with -DRA_BENCHMARK this file becomes a benchmark executable instead of the analyzer. It times the hot
+paths on deterministic synthetic histories (uniform draws from an mt19937_64 with a fixed seed, so every run
+sees the same input) and writes one JSON object per measurement to stdout, for comparing runs and sizing
+hardware. Everything else the analyzer prints goes to stderr.
+
+    Random-Analysis-Bench [--max-draws N] [--repeat N] [--seed N] [--threads N] [--skip-combinations]
+                          [--max-levels N] [--memory-budget BYTES] [--retire-sample-size N] [--pipeline-threads N]
+
+History lengths run from 10^3 in powers of ten up to --max-draws (default 10^4, at most 10^7). The cost of a draw
+grows with the depth of the ordinal tree, which grows with the history, so the long histories take a while
+unless the tree is bounded with the growth options (see OrdinalGrowthPolicy). With --pipeline-threads the history is
+also replayed through pipelined ingest on that many threads (see Analyse::analyse_draws_pipelined).*/
+
+struct BenchmarkResult {
+    const char *name;
+    long long draws;         // Length of the synthetic history the state was built from; 0 when not applicable.
+    long long operations;    // Number of draws, cards or calls timed.
+    const char *unit;        // What one operation is: "draw", "card" or "call".
+    double seconds;          // Total time of the timed operations.
+    int levels;              // Depth of the ordinal tree after the run, retired levels included.
+};
 
-    cerr << "Enter config file path (default: configs): ";
-    string userInput;
-    getline(cin, userInput);
+// The machine-readable output; bound to the real stdout while std::cout is sent to stderr.
+static std::ostream *_benchmarkOutput = &std::cout;
+
+// Peak resident set size of the process so far, in kilobytes (0 where it is not available).
+static long peak_rss_kb() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return static_cast<long>(usage.ru_maxrss / 1024);   // Bytes on macOS.
+#else
+    return static_cast<long>(usage.ru_maxrss);
+#endif
+#else
+    return 0;
+#endif
+}
 
-    if (!userInput.empty()) {
-        configFilePath = userInput;
+static void report_benchmark(const BenchmarkResult& result) {
+    double perOperation = result.operations > 0 ? result.seconds * 1e9 / static_cast<double>(result.operations) : 0.0;
+    *_benchmarkOutput << "{\"benchmark\":\"" << result.name << "\""
+                      << ",\"range\":" << _drawRange << ",\"card\":" << _drawCardSize
+                      << ",\"draws\":" << result.draws
+                      << ",\"operations\":" << result.operations
+                      << ",\"unit\":\"" << result.unit << "\""
+                      << ",\"seconds\":" << std::setprecision(9) << result.seconds
+                      << ",\"ns_per_op\":" << std::setprecision(6) << perOperation
+                      << ",\"levels\":" << result.levels
+                      << ",\"peak_rss_kb\":" << peak_rss_kb() << "}" << std::endl;
+    std::cerr << "[Bench] " << std::left << std::setw(28) << result.name << std::right
+              << " draws " << std::setw(9) << result.draws
+              << "  " << std::fixed << std::setprecision(1) << std::setw(12) << perOperation << " ns/" << result.unit
+              << "  levels " << std::setw(6) << result.levels
+              << "  peak RSS " << peak_rss_kb() << " KB" << std::defaultfloat << std::endl;
+}
+
+// Fills 'history' with 'draws' uniform draws from 'seed'. Dates are valid and increasing (28 draws a month).
+static void generate_synthetic_history(std::vector<DrawRecord>& history, long long draws, uint64_t seed) {
+    std::mt19937_64 stream(seed);
+    std::uniform_int_distribution<int> ballDistribution(1, _drawRange);
+    history.resize(static_cast<size_t>(draws));
+    for (long long index = 0; index < draws; index++) {
+        DrawRecord& draw = history[static_cast<size_t>(index)];
+        uint32_t year = 1000 + static_cast<uint32_t>(index / 336 % 9000);
+        uint32_t month = static_cast<uint32_t>(index / 28 % 12) + 1;
+        uint32_t day = static_cast<uint32_t>(index % 28) + 1;
+        draw.date = year * 10000 + month * 100 + day;
+        uniform_draw(stream, ballDistribution, draw);
     }
+}
 
-    if (!load_config(configFilePath, config)) {
-        cerr << "Using default settings." << endl;
+// Writes 'history' as a draw history CSV file. Returns false on a write error.
+static bool write_synthetic_history(const char *path, const std::vector<DrawRecord>& history) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        cerr << "[Error] Failed to open file for writing: " << path << endl;
+        return false;
+    }
+    std::string text = "Date";
+    for (int slot = 0; slot < _drawCardSize; slot++)
+        text += ",Ball" + std::to_string(slot + 1);
+    text += '\n';
+    char row[16 + 4 * _drawCardSize];
+    for (const DrawRecord& draw : history) {
+        int length = snprintf(row, sizeof(row), "%04u-%02u-%02u", draw.date / 10000, draw.date / 100 % 100, draw.date % 100);
+        for (int slot = 0; slot < _drawCardSize; slot++)
+            length += snprintf(row + length, sizeof(row) - length, ",%d", draw.balls[slot]);
+        row[length++] = '\n';
+        text.append(row, length);
+        if (text.size() >= (1 << 20)) {
+            fwrite(text.data(), 1, text.size(), file);
+            text.clear();
+        }
     }
+    fwrite(text.data(), 1, text.size(), file);
+    bool written = !ferror(file);
+    written = (fclose(file) == 0) && written;
+    if (!written)
+        cerr << "[Error] Failed to write file: " << path << endl;
+    return written;
+}
 
-if (config.debugMode) {
-        std::cerr << "Combinations file: " << config.combinationCollectionFile << std::endl;
-        std::cerr << "Draw history file: " << config.drawHistoryFile << std::endl;
-        std::cerr << "Debug mode: " << (config.debugMode ? "Enabled" : "Disabled") << std::endl;
+// Runs every benchmark that depends on the history length on a synthetic history of 'draws' draws.
+static void run_history_benchmarks(long long draws, long long repeat, uint64_t seed, int threads, const OrdinalGrowthPolicy& growth,
+                                   const RecencyPolicy& recency, int pipelineThreads) {
+    using Clock = std::chrono::steady_clock;
+    auto seconds_since = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+    std::vector<DrawRecord> history;
+    generate_synthetic_history(history, draws, seed);
+
+    // CSV ingestion: map and decode the history file.
+    {
+        static const char historyPath[] = "bench-draw-history.csv";
+        if (write_synthetic_history(historyPath, history)) {
+            std::unique_ptr<Analyse> analyser(new Analyse());
+            analyser->init_all();
+            strncpy(analyser->_drawHistoryFile, historyPath, sizeof(analyser->_drawHistoryFile) - 1);
+            analyser->_drawHistoryFile[sizeof(analyser->_drawHistoryFile) - 1] = '\0';
+            auto start = Clock::now();
+            analyser->load_draw_history();
+            double elapsed = seconds_since(start);
+            if (static_cast<long long>(analyser->_drawHistory.size()) != draws)
+                cerr << "[Error] Ingested " << analyser->_drawHistory.size() << " of " << draws << " draws." << endl;
+            report_benchmark({"csv_ingest", draws, draws, "draw", elapsed, 0});
+            remove(historyPath);
+        }
     }
 
-    Analyse drawData;
-    drawData._debugMode = config.debugMode;
+    // The whole draw pipeline, one draw at a time, as the analyzer runs it.
+    std::unique_ptr<Analyse> analyser(new Analyse());
+    analyser->_workerThreads = threads;
+    analyser->_ordinalGrowth = growth;
+    analyser->_recency = recency;
+    analyser->init_all();
+    {
+        auto start = Clock::now();
+        for (const DrawRecord& draw : history)
+            analyser->analyse_draw(draw);
+        report_benchmark({"analyse_draw", draws, draws, "draw", seconds_since(start), analyser->_ordinalBranchTotalNodes});
+    }
+
+    // The same replay with the ordinal levels split between pipeline stages; it does not retire levels.
+    if (pipelineThreads > 1 && growth.retireSampleSize == 0) {
+        std::unique_ptr<Analyse> pipelined(new Analyse());
+        pipelined->_pipelineThreads = pipelineThreads;
+        pipelined->_ordinalGrowth = growth;
+        pipelined->_recency = recency;
+        pipelined->init_all();
+        pipelined->_drawHistory = history;
+        auto start = Clock::now();
+        pipelined->analyse_draws_pipelined(0, static_cast<int>(draws));
+        report_benchmark({"pipelined_replay", draws, draws, "draw", seconds_since(start), pipelined->_ordinalBranchTotalNodes});
+    }
+
+    // The single steps, each on its own copy of the state the history left behind, so none of them runs on
+    // levels or counts an earlier one added. The ordinances (ranks, from 1) are drawn up front.
+    auto replayed = [&]() {
+        std::unique_ptr<Analyse> copy(new Analyse());
+        analyser->copy_replay_parameters(*copy);
+        copy->_workerThreads = threads;
+        copy->copy_analysis_state(*analyser);
+        return copy;
+    };
+
+    std::mt19937_64 stream(seed ^ static_cast<uint64_t>(draws));
+    std::uniform_int_distribution<int> ordinanceDistribution(1, _drawRange);
+    std::vector<int> ordinances(static_cast<size_t>(repeat));
+    for (int& ordinance : ordinances)
+        ordinance = ordinanceDistribution(stream);
+
+    {
+        std::unique_ptr<Analyse> state = replayed();
+        auto start = Clock::now();
+        for (int ordinance : ordinances)
+            state->record_ordinal_opportunity(ordinance);
+        report_benchmark({"record_ordinal_opportunity", draws, repeat, "call", seconds_since(start), state->_ordinalBranchTotalNodes});
+    }
+    {
+        std::unique_ptr<Analyse> state = replayed();
+        auto start = Clock::now();
+        for (int ordinance : ordinances)
+            state->calculate_ordinal_event(ordinance);
+        report_benchmark({"calculate_ordinal_event", draws, repeat, "call", seconds_since(start), state->_ordinalBranchTotalNodes});
+    }
+    {
+        std::unique_ptr<Analyse> state = replayed();
+        // Each sort follows one opportunity, so every level has moved a little, as after a draw.
+        double elapsed = 0.0;
+        for (int ordinance : ordinances) {
+            state->record_ordinal_opportunity(ordinance);
+            auto start = Clock::now();
+            state->sort_ordinal_lists();
+            elapsed += seconds_since(start);
+        }
+        report_benchmark({"sort_ordinal_lists", draws, repeat, "call", elapsed, state->_ordinalBranchTotalNodes});
+    }
+    {
+        std::unique_ptr<Analyse> state = replayed();
+        // Each sort follows one draw event, so one ball has moved, as after a draw.
+        double elapsed = 0.0;
+        for (int ordinance : ordinances) {
+            state->calculate_draw_event(state->_drawStats.rankedBall[ordinance - 1]);
+            state->reset_flags();
+            auto start = Clock::now();
+            state->sort_draws_average();
+            elapsed += seconds_since(start);
+        }
+        report_benchmark({"sort_draws_average", draws, repeat, "call", elapsed, state->_ordinalBranchTotalNodes});
+    }
+    {
+        std::unique_ptr<Analyse> state = replayed();
+        auto start = Clock::now();
+        for (long long call = 0; call < repeat; call++)
+            state->record_co_occurrence(history[static_cast<size_t>(call % draws)]);
+        report_benchmark({"record_co_occurrence", draws, repeat, "call", seconds_since(start), state->_ordinalBranchTotalNodes});
+    }
+    {
+        std::unique_ptr<Analyse> state = replayed();
+        long long calls = std::max(1LL, repeat / 100);
+        size_t found = 0;
+        auto start = Clock::now();
+        for (long long call = 0; call < calls; call++)
+            found += state->top_triples(10).size();
+        report_benchmark({"top_triples", draws, calls, "call", seconds_since(start), state->_ordinalBranchTotalNodes});
+        if (found == 0) cerr << found;   // Keeps the queries from being optimized away.
+    }
+    {
+        std::unique_ptr<Analyse> state = replayed();
+        long long calls = std::max(1LL, repeat / 10);
+        auto start = Clock::now();
+        for (long long call = 0; call < calls; call++)
+            state->correlate_data();
+        report_benchmark({"correlate_data", draws, calls, "call", seconds_since(start), state->_ordinalBranchTotalNodes});
+    }
+}
+
+// Runs the card benchmarks, which do not depend on the history.
+static void run_card_benchmarks(long long repeat, uint64_t seed, int threads, bool withCombinations) {
+    using Clock = std::chrono::steady_clock;
+    std::unique_ptr<Analyse> analyser(new Analyse());
+    analyser->_workerThreads = threads;
+    analyser->init_all();
+
+    {
+        std::vector<DrawRecord> cards;
+        generate_synthetic_history(cards, std::max(repeat, 1LL << 20), seed);
+        long long valid = 0;
+        auto start = Clock::now();
+        for (const DrawRecord& draw : cards) {
+            Card card;
+            for (int slot = 0; slot < _drawCardSize; slot++)
+                card[slot] = draw.balls[slot];
+            valid += analyser->validate_draw_combination(card);
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        report_benchmark({"validate_draw_combination", 0, static_cast<long long>(cards.size()), "card", elapsed, 0});
+        if (valid < 0) cerr << valid;   // Keeps the loop from being optimized away.
+    }
+
+    if (withCombinations) {
+        static const char combinationPath[] = "bench-combinations.txt";
+        strncpy(analyser->_combinationCollectionFile, combinationPath, sizeof(analyser->_combinationCollectionFile) - 1);
+        analyser->_combinationCollectionFile[sizeof(analyser->_combinationCollectionFile) - 1] = '\0';
+        auto start = Clock::now();
+        analyser->create_all_combinations();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        report_benchmark({"create_all_combinations", 0, binomial(_drawRange, _drawCardSize), "card", elapsed, 0});
+        remove(combinationPath);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long long maxDraws = 10000;
+    long long repeat = 10000;
+    uint64_t seed = 20240101;
+    int threads = 0;
+    bool withCombinations = true;
+    OrdinalGrowthPolicy growth;
+    RecencyPolicy recency;
+    int pipelineThreads = 0;
+
+    for (int arg = 1; arg < argc; arg++) {
+        string option = argv[arg];
+        bool hasValue = arg + 1 < argc;
+        if (option == "--max-draws" && hasValue) maxDraws = std::stoll(argv[++arg]);
+        else if (option == "--repeat" && hasValue) repeat = std::stoll(argv[++arg]);
+        else if (option == "--seed" && hasValue) seed = std::stoull(argv[++arg]);
+        else if (option == "--threads" && hasValue) threads = std::stoi(argv[++arg]);
+        else if (option == "--skip-combinations") withCombinations = false;
+        else if (option == "--max-levels" && hasValue) growth.maxLevels = std::stoi(argv[++arg]);
+        else if (option == "--memory-budget" && hasValue) growth.memoryBudget = std::stoull(argv[++arg]);
+        else if (option == "--retire-sample-size" && hasValue) growth.retireSampleSize = std::stoi(argv[++arg]);
+        else if (option == "--statistic-window" && hasValue) recency.window = std::max(0, std::stoi(argv[++arg]));
+        else if (option == "--statistic-decay" && hasValue) recency.decay = std::stod(argv[++arg]);
+        else if (option == "--rank-by-window") recency.ranking = RankingStatistic::Window;
+        else if (option == "--rank-by-decayed") recency.ranking = RankingStatistic::Decayed;
+        else if (option == "--pipeline-threads" && hasValue) pipelineThreads = std::max(0, std::stoi(argv[++arg]));
+        else {
+            cerr << "Usage: " << argv[0] << " [--max-draws N] [--repeat N] [--seed N] [--threads N] [--skip-combinations]"
+                 << " [--max-levels N] [--memory-budget BYTES] [--retire-sample-size N]"
+                 << " [--statistic-window N] [--statistic-decay D] [--rank-by-window | --rank-by-decayed]"
+                 << " [--pipeline-threads N]" << endl;
+            return 1;
+        }
+    }
+    maxDraws = std::min(maxDraws, 10000000LL);
+    repeat = std::max(repeat, 1LL);
+
+    // The analyzer reports on std::cout; keep stdout for the measurements alone.
+    std::ostream measurements(std::cout.rdbuf());
+    _benchmarkOutput = &measurements;
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    for (long long draws = 1000; draws <= maxDraws; draws *= 10)
+        run_history_benchmarks(draws, repeat, seed, threads, growth, recency, pipelineThreads);
+    run_card_benchmarks(repeat, seed, threads, withCombinations);
+
+    std::cout.rdbuf(measurements.rdbuf());
+    return 0;
+}
+
+#else
+// Copies a configuration into an analyzer. Returns false when a path does not fit the analyzer's buffers.
+static bool configure_analyser(const Config& config, Analyse& drawData) {
+    drawData._debugMode = config.debugMode || config.logLevel <= LogLevel::Debug;
+    drawData._workerThreads = config.workerThreads;
 
     // Fault tolerance for strncpy
     if (config.combinationCollectionFile.size() >= sizeof(drawData._combinationCollectionFile)) {
         std::cerr << "Error: combinationCollectionFile is too long!" << std::endl;
-        return 1;
+        return false;
     }
     if (config.drawHistoryFile.size() >= sizeof(drawData._drawHistoryFile)) {
         std::cerr << "Error: drawHistoryFile is too long!" << std::endl;
-        return 1;
+        return false;
+    }
+    if (config.combinationIndexFile.size() >= sizeof(drawData._combinationIndexFile)) {
+        std::cerr << "Error: combinationIndexFile is too long!" << std::endl;
+        return false;
+    }
+    if (config.snapshotFile.size() >= sizeof(drawData._snapshotFile)) {
+        std::cerr << "Error: snapshotFile is too long!" << std::endl;
+        return false;
+    }
+    if (config.exportPrefix.size() + sizeof(".ordinals.jsonl") > sizeof(drawData._exportPrefix)) {
+        std::cerr << "Error: exportPrefix is too long!" << std::endl;
+        return false;
     }
 
     strncpy(drawData._combinationCollectionFile, config.combinationCollectionFile.c_str(), sizeof(drawData._combinationCollectionFile) - 1);
@@ -1305,32 +5071,275 @@ if (config.debugMode) {
     strncpy(drawData._drawHistoryFile, config.drawHistoryFile.c_str(), sizeof(drawData._drawHistoryFile) - 1);
     drawData._drawHistoryFile[sizeof(drawData._drawHistoryFile) - 1] = '\0'; // Ensure null termination
 
-    if (config.debugMode) {
-        std::cerr << "Combination file path set to: " << drawData._combinationCollectionFile << std::endl;
-        std::cerr << "Draw history file path set to: " << drawData._drawHistoryFile << std::endl;
+    strncpy(drawData._combinationIndexFile, config.combinationIndexFile.c_str(), sizeof(drawData._combinationIndexFile) - 1);
+    drawData._combinationIndexFile[sizeof(drawData._combinationIndexFile) - 1] = '\0'; // Ensure null termination
+    drawData._combinationRankList = config.combinationRankList;
+    drawData._watchHistory = config.watchHistory;
+    drawData._drawSampleSize = config.drawSampleSize;
+    drawData._ordinalSampleSize = config.ordinalSampleSize;
+    drawData._ordinalGrowth.maxLevels = config.ordinalMaxLevels;
+    drawData._ordinalGrowth.memoryBudget = static_cast<size_t>(config.ordinalMemoryBudget);
+    drawData._ordinalGrowth.retireSampleSize = config.ordinalRetireSampleSize;
+    drawData._correlateEveryDraw = config.correlateEveryDraw;
+    drawData._pipelineThreads = config.pipelineThreads;
+    drawData._recency.window = config.statisticWindow;
+    drawData._recency.decay = config.statisticDecay;
+    drawData._recency.ranking = config.rankingStatistic;
+    if (!drawData._recency.keeps(config.rankingStatistic)) {
+        std::cerr << "[Warning] rankingStatistic needs its statisticWindow or statisticDecay; ranking by lifetime averages." << std::endl;
+        drawData._recency.ranking = RankingStatistic::Lifetime;
     }
+    drawData._loadTest = config.loadTest;
+    drawData._testDrawCount = config.testDrawCount;
 
-    drawData.init_all();
+    strncpy(drawData._snapshotFile, config.snapshotFile.c_str(), sizeof(drawData._snapshotFile) - 1);
+    drawData._snapshotFile[sizeof(drawData._snapshotFile) - 1] = '\0'; // Ensure null termination
 
-    // Load combinations from file or create them if loading fails
-    FILE* combinationFile = fopen(drawData._combinationCollectionFile, "r");
-    if (!combinationFile) {
-        if (config.debugMode) {
-            std::cerr << "Error opening combination file: " << drawData._combinationCollectionFile << " (" << strerror(errno) << ")" << std::endl;
-            std::cerr << "Creating new combinations..." << std::endl;
-        }
-    //    drawData.create_all_combinations();
-    } else {
-        if (config.debugMode) {
-            std::cerr << "Combination file opened successfully: " << drawData._combinationCollectionFile << std::endl;
-        }
-        fclose(combinationFile);
+    strncpy(drawData._exportPrefix, config.exportPrefix.c_str(), sizeof(drawData._exportPrefix) - 1);
+    drawData._exportPrefix[sizeof(drawData._exportPrefix) - 1] = '\0'; // Ensure null termination
+    drawData._exportFormats = config.exportFormats;
+
+    if (config.debugMode) {
+        std::cerr << "Combination file path set to: " << drawData._combinationCollectionFile << std::endl;
+        std::cerr << "Draw history file path set to: " << drawData._drawHistoryFile << std::endl;
     }
+    return true;
+}
 
+// Runs the analysis a configuration asks for on a configured, initialized analyzer: the draw engine,
+// the displays and exports, and the optional engines. Watching the history is left to the caller.
+// Returns false, after reporting it, when the history holds no valid draw for this build's game.
+static bool run_analysis(const Config& config, Analyse& drawData) {
     // Run the draw engine
     drawData.analyse_all_draws();
+    if (drawData._drawHistoryTotal == 0) {
+        *drawData._report << "[Error] No valid draws in " << drawData._drawHistoryFile << "; this build reads draws of "
+                          << _drawCardSize << " numbers from 1-" << _drawRange << "." << std::endl;
+        return false;
+    }
 	drawData.correlate_data();
 	drawData.display_draw_statistics();
 	drawData.display_ordinal_lists();
-    return 0;
+
+    // Write the statistics for downstream tools
+    if (drawData._exportFormats)
+        drawData.export_statistics(drawData._exportPrefix, drawData._exportFormats);
+
+    // The pairs and triples drawn together most often
+    if (config.coOccurrenceTop > 0)
+        drawData.display_co_occurrence(config.coOccurrenceTop);
+
+    // Rank every valid card by the per-ball statistics
+    if (config.scoreTopCards > 0) {
+        double weights[_drawRange + 1];
+        drawData.card_score_weights(config.scoreMetric, weights);
+        drawData.display_card_scores(drawData.score_all_combinations(weights, config.scoreCombine, config.scoreTopCards));
+    }
+
+    // Null distributions from uniform synthetic histories
+    if (config.simulations > 0)
+        drawData.display_null_distribution(drawData.run_null_simulations(config.simulations, config.simulationSeed));
+
+    // Walk-forward backtest over the draw history
+    if (config.backtestSplits > 0)
+        drawData.display_backtest(drawData.run_backtest(config.backtestSplits, config.backtestHorizon, config.backtestTopN));
+
+    // Parameter sweep over the sample-size thresholds and holdout sizes
+    if (!config.sweepDrawSampleSizes.empty() || !config.sweepOrdinalSampleSizes.empty() || !config.sweepTestDrawCounts.empty()) {
+        std::vector<int> drawSampleSizes = config.sweepDrawSampleSizes.empty() ? std::vector<int>{config.drawSampleSize} : config.sweepDrawSampleSizes;
+        std::vector<int> ordinalSampleSizes = config.sweepOrdinalSampleSizes.empty() ? std::vector<int>{config.ordinalSampleSize} : config.sweepOrdinalSampleSizes;
+        std::vector<int> testDrawCounts = config.sweepTestDrawCounts.empty() ? std::vector<int>{config.testDrawCount} : config.sweepTestDrawCounts;
+        std::vector<SweepParameters> grid;
+        for (int drawSampleSize : drawSampleSizes)
+            for (int ordinalSampleSize : ordinalSampleSizes)
+                for (int testDrawCount : testDrawCounts)
+                    grid.push_back({drawSampleSize, ordinalSampleSize, testDrawCount});
+        drawData.display_parameter_sweep(drawData.run_parameter_sweep(grid, config.backtestTopN), config.backtestTopN);
+    }
+    return true;
+}
+
+static int run_batch(const std::vector<string>& configPaths) {
+/* Function to analyse several draw histories of the game this build is specialized for (regional or
+date-range variants, differently tuned configurations) in one process. The game geometry is fixed at
+compile time, so every history must have the build's numbers per draw and range; an entry whose history
+holds no valid draw is reported as failed. Every config file gets its own Analyse instance, so the runs
+share nothing but the constant game geometry and the logger. The instances are configured and their combination indexes attached one after another,
+since two entries may share an index file and a missing one is built in place; then the analyses run side
+by side on one thread pool, so the batch takes about as long as its slowest history. Each instance writes
+its report into its own buffer, and the reports are printed in list order once every run has finished.
+The logger is the one thing configured for the whole process: it runs at the lowest logLevel of the
+entries, and its records go straight to stderr as they happen, not into an entry's report. Only the
+entries with debug mode on (see Analyse::_debugMode) write debug and trace records; every other message of
+an entry goes to its report.*/
+
+    struct BatchEntry {
+        string configPath;
+        Config config;
+        std::unique_ptr<Analyse> analyser;
+        std::ostringstream report;
+        double seconds = 0.0;
+        bool analysed = false;     // The history held valid draws and the analysis ran.
+    };
+    std::vector<std::unique_ptr<BatchEntry>> entries;
+    LogLevel logLevel = LogLevel::Error;
+    bool failed = false;
+
+    for (const string& path : configPaths) {
+        std::unique_ptr<BatchEntry> entry(new BatchEntry());
+        entry->configPath = path;
+        if (!load_config(path, entry->config)) {
+            cerr << "[Error] Cannot read batch config: " << path << "; skipping it." << endl;
+            failed = true;
+            continue;
+        }
+        const Config& config = entry->config;
+
+        // Two runs writing the same snapshot or export files would overwrite each other.
+        bool clash = false;
+        for (const auto& other : entries) {
+            clash = clash || (!config.snapshotFile.empty() && config.snapshotFile == other->config.snapshotFile)
+                          || (config.exportFormats && other->config.exportFormats && config.exportPrefix == other->config.exportPrefix);
+        }
+        if (clash) {
+            cerr << "[Error] " << path << " writes the same snapshot or export files as an earlier entry; skipping it." << endl;
+            failed = true;
+            continue;
+        }
+        if (config.watchHistory)
+            cerr << "[Warning] watchHistory is ignored in batch mode: " << path << endl;
+
+        entry->analyser.reset(new Analyse());
+        Analyse& analyser = *entry->analyser;
+        if (!configure_analyser(config, analyser)) {
+            failed = true;
+            continue;
+        }
+        analyser._report = &entry->report;
+        analyser.init_all();
+        if (config.scoreTopCards > 0)
+            analyser.load_combination_index();
+        // The logger is process-wide, so it takes the most verbose level any entry asks for.
+        logLevel = std::min(logLevel, config.debugMode ? std::min(config.logLevel, LogLevel::Debug) : config.logLevel);
+        entries.push_back(std::move(entry));
+    }
+    if (entries.empty())
+        return 1;
+    _log.set_level(logLevel);
+
+    // One history per worker; each run only touches its own instance and buffer.
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool(std::min(cores, static_cast<unsigned>(entries.size())));
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& entry : entries) {
+        BatchEntry *job = entry.get();
+        pool.submit([job]() {
+            auto runStart = std::chrono::steady_clock::now();
+            job->analysed = run_analysis(job->config, *job->analyser);
+            job->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+        });
+    }
+    pool.wait();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The collated report, in list order.
+    double analysisSeconds = 0.0;
+    size_t analysed = 0;
+    for (size_t index = 0; index < entries.size(); index++) {
+        const BatchEntry& entry = *entries[index];
+        analysed += entry.analysed;
+        failed = failed || !entry.analysed;
+        cerr << "===== History " << index + 1 << " of " << entries.size() << ": " << entry.configPath
+             << " (" << entry.config.drawHistoryFile << ", " << entry.seconds << " s) =====" << endl;
+        cerr << entry.report.str();
+        analysisSeconds += entry.seconds;
+    }
+    cerr << "[Info] Analysed " << analysed << " of " << entries.size() << " histories in " << elapsed << " s ("
+         << analysisSeconds << " s of analysis in total)." << endl;
+    if (analysed < entries.size())
+        cerr << "[Error] " << entries.size() - analysed << " histories had no valid draws for this build." << endl;
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    Config config;
+    bool profile = false;
+    std::vector<string> batchConfigs;
+
+    for (int arg = 1; arg < argc; arg++) {
+        string option = argv[arg];
+        if (option == "--profile") {
+            profile = true;
+        } else if (option == "--batch" && arg + 1 < argc) {
+            while (++arg < argc)
+                batchConfigs.push_back(argv[arg]);
+        } else {
+            cerr << "Usage: " << argv[0] << " [--profile] [--batch CONFIG...]" << endl;
+            return 1;
+        }
+    }
+#if defined(RA_PROFILE)
+    if (profile)
+        start_profile_hardware();
+#else
+    if (profile)
+        cerr << "[Warning] Built without RA_PROFILE; there is no profile to report." << endl;
+#endif
+
+    // Batch mode: every config file listed is a separate history, analysed concurrently.
+    if (!batchConfigs.empty()) {
+        int status = run_batch(batchConfigs);
+#if defined(RA_PROFILE)
+        if (profile)
+            report_profile(std::cerr);
+#endif
+        return status;
+    }
+    string configFilePath = "configs";
+
+    cerr << "Enter config file path (default: configs): ";
+    string userInput;
+    getline(cin, userInput);
+
+    if (!userInput.empty()) {
+        configFilePath = userInput;
+    }
+
+    if (!load_config(configFilePath, config)) {
+        cerr << "Using default settings." << endl;
+    }
+
+if (config.debugMode) {
+        std::cerr << "Combinations file: " << config.combinationCollectionFile << std::endl;
+        std::cerr << "Draw history file: " << config.drawHistoryFile << std::endl;
+        std::cerr << "Debug mode: " << (config.debugMode ? "Enabled" : "Disabled") << std::endl;
+    }
+
+    _log.set_level(config.debugMode ? std::min(config.logLevel, LogLevel::Debug) : config.logLevel);
+
+    Analyse drawData;
+    if (!configure_analyser(config, drawData))
+        return 1;
+
+    drawData.init_all();
+
+    // Attach the combination index, or create it if loading fails; only the scoring run reads it.
+    if (config.scoreTopCards > 0 && drawData.load_combination_index() && config.debugMode) {
+        std::cerr << "Combination index attached: " << drawData._combinationIndexFile << " ("
+                  << drawData._combinationIndex.valid_cards() << " valid of " << drawData._combinationIndex.total_cards() << " cards)" << std::endl;
+    }
+
+    // An empty history is only fine when its draws are still to come.
+    bool analysed = run_analysis(config, drawData);
+
+    // Stay resident and follow the draw history file
+    if (config.watchHistory)
+        drawData.watch_draw_history();
+
+#if defined(RA_PROFILE)
+    if (profile)
+        report_profile(std::cerr);
+#endif
+    return analysed || config.watchHistory ? 0 : 1;
 }
+#endif